@@ -1,29 +1,94 @@
 #include "backend.h"
 #include <cmath>
 #include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <vector>
 
-// Помощная функция для проверки, атаковано ли поле фигурами противника.
-// Можно использовать логику из isInCheck, но подставить нашу цель.
-bool ChessGame::isSquareAttacked(int row, int col, char opponentColor, const char boardState[SIZE][SIZE]) {
-    // Проходим по всем фигурам противника и проверяем, могут ли они пойти на (row, col)
-    for (int r = 0; r < SIZE; r++) {
-        for (int c = 0; c < SIZE; c++) {
-            char p = boardState[r][c];
-            if (p == '.') continue;
-
-            if ((opponentColor == 'W' && p >= 'A' && p <= 'Z') ||
-                (opponentColor == 'B' && p >= 'a' && p <= 'z')) {
-                // Проверяем, легален ли ход этой фигуры на (row, col)
-                // ignoreCheck=true, чтобы не зациклиться
-                char pcColor = (p >= 'A' && p <= 'Z') ? 'W' : 'B';
-                if (isValidMove(r, c, row, col, pcColor, true, boardState)) {
-                    return true;
+// Нападающие цвета attackerColor на клетку square произвольной доски. Поиск идёт от клетки наружу:
+// поля коротких фигур берутся из таблиц атак, лучи дальнобойных идут до первой занятой клетки.
+// Если all == false, возвращается сразу после первого найденного нападающего.
+static Bitboard scanAttackers(const char boardState[SIZE][SIZE], int square, int attackerColor, bool all) {
+    bool white = (attackerColor == WHITE);
+    auto pieceOn = [&](int sq) { return boardState[squareRow(sq)][squareCol(sq)]; };
+    Bitboard attackers = 0;
+
+    // Короткие фигуры: клетки, с которых фигура нужного типа бьёт square
+    struct Leaper { Bitboard from; char piece; };
+    const Leaper leapers[3] = {
+        {pawnAttacks(square, !white), white ? 'P' : 'p'},
+        {knightAttacks(square), white ? 'N' : 'n'},
+        {kingAttacks(square), white ? 'K' : 'k'},
+    };
+    for (const Leaper& leaper : leapers) {
+        Bitboard from = leaper.from;
+        while (from) {
+            int sq = popLsb(from);
+            if (pieceOn(sq) == leaper.piece) {
+                attackers |= squareBB(sq);
+                if (!all) return attackers;
+            }
+        }
+    }
+
+    // Лучи: первые четыре направления - по прямой (ладья, ферзь), остальные - по диагонали (слон, ферзь)
+    static const int directions[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+    char queen = white ? 'Q' : 'q';
+    for (int d = 0; d < 8; ++d) {
+        char slider = (d < 4) ? (white ? 'R' : 'r') : (white ? 'B' : 'b');
+        int row = squareRow(square) + directions[d][0];
+        int col = squareCol(square) + directions[d][1];
+        while (row >= 0 && row < SIZE && col >= 0 && col < SIZE) {
+            char piece = boardState[row][col];
+            if (piece != '.') {
+                if (piece == slider || piece == queen) {
+                    attackers |= squareBB(makeSquare(row, col));
+                    if (!all) return attackers;
                 }
+                break;
             }
+            row += directions[d][0];
+            col += directions[d][1];
         }
     }
-    return false;
+    return attackers;
+}
+
+// Помощная функция для проверки, атаковано ли поле фигурами противника.
+// Для собственной доски используется position, для произвольной - обход от клетки без построения позиции.
+bool ChessGame::isSquareAttacked(int row, int col, char opponentColor, const char boardState[SIZE][SIZE]) {
+    int attackerColor = (opponentColor == 'W') ? WHITE : BLACK;
+    if (boardState == nullptr || boardState == board) {
+        return position.isAttacked(makeSquare(row, col), attackerColor);
+    }
+    return scanAttackers(boardState, makeSquare(row, col), attackerColor, false) != 0;
+}
+
+Bitboard ChessGame::attackersOf(int row, int col, char opponentColor, const char boardState[SIZE][SIZE]) {
+    int attackerColor = (opponentColor == 'W') ? WHITE : BLACK;
+    if (boardState == nullptr || boardState == board) {
+        return position.attackersTo(makeSquare(row, col), attackerColor, position.occupied);
+    }
+    return scanAttackers(boardState, makeSquare(row, col), attackerColor, true);
+}
+
+bool ChessGame::isHanging(int row, int col) const {
+    int square = makeSquare(row, col);
+    char piece = position.pieceAt(square);
+    if (piece == '.') return false;
+    return position.exchangeGain(square, pieceColor(piece) ^ 1) > 0;
+}
+
+Move unpackMove(PackedMove move, const Position& pos) {
+    int from = moveFrom(move);
+    int to = moveTo(move);
+    char piece = pos.pieceAt(from);
+    return {piece, squareRow(from), squareCol(from), squareRow(to), squareCol(to),
+            (pieceColor(piece) == WHITE) ? 'W' : 'B'};
+}
+
+PackedMove packMove(const Move& move, const Position& pos) {
+    return pos.encodeMove(makeSquare(move.fromRow, move.fromCol), makeSquare(move.toRow, move.toCol));
 }
 
 ChessGame::ChessGame(GameMode mode) : gameMode(mode) {
@@ -34,6 +99,9 @@ ChessGame::ChessGame(GameMode mode) : gameMode(mode) {
     enPassantTargetRow = -1;
     enPassantTargetCol = -1;
     currentPlayer = 'W';
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    checkInfoValid[0] = checkInfoValid[1] = false;
     initializeBoard();
 }
 
@@ -53,6 +121,228 @@ void ChessGame::initializeBoard() {
     whiteCapturedPieces.clear();
     blackCapturedPieces.clear();
     moveHistory.clear();
+
+    syncPosition();
+}
+
+void ChessGame::syncPosition() {
+    position.setFromBoard(board);
+    syncPositionState();
+}
+
+// Права на рокировку по флагам "король/ладья ходили" и расстановке на доске
+int ChessGame::castlingRightsOf(const char currentBoard[SIZE][SIZE]) const {
+    int rights = 0;
+    if (!whiteKingMoved && currentBoard[7][4] == 'K') {
+        if (!whiteRookMoved[1] && currentBoard[7][7] == 'R') rights |= WHITE_OO;
+        if (!whiteRookMoved[0] && currentBoard[7][0] == 'R') rights |= WHITE_OOO;
+    }
+    if (!blackKingMoved && currentBoard[0][4] == 'k') {
+        if (!blackRookMoved[1] && currentBoard[0][7] == 'r') rights |= BLACK_OO;
+        if (!blackRookMoved[0] && currentBoard[0][0] == 'r') rights |= BLACK_OOO;
+    }
+    return rights;
+}
+
+void ChessGame::syncPositionState() {
+    // Сеттеры обновляют ключ Zobrist инкрементально
+    position.setCastlingRights(castlingRightsOf(board));
+    position.setEpSquare((enPassantTargetRow == -1) ? -1 : makeSquare(enPassantTargetRow, enPassantTargetCol));
+    position.setSideToMove((currentPlayer == 'W') ? WHITE : BLACK);
+
+    // Пока ходов нет, история начинается с текущей позиции
+    if (moveHistory.empty()) historyStart = position;
+}
+
+void ChessGame::setSquare(int row, int col, char piece) {
+    int square = makeSquare(row, col);
+    if (board[row][col] != '.') position.removePiece(square);
+    board[row][col] = piece;
+    if (piece != '.') position.putPiece(piece, square);
+}
+
+// Пропускает пробелы и возвращает следующее поле строки (пустое, если полей больше нет)
+static std::string_view nextField(std::string_view& text) {
+    size_t begin = 0;
+    while (begin < text.size() && (text[begin] == ' ' || text[begin] == '\t')) ++begin;
+    size_t end = begin;
+    while (end < text.size() && text[end] != ' ' && text[end] != '\t') ++end;
+    std::string_view field = text.substr(begin, end - begin);
+    text.remove_prefix(end);
+    return field;
+}
+
+// Разбирает доску, очередь хода, рокировки и взятие на проходе (первые четыре поля FEN и EPD).
+// Состояние игры меняется только если все четыре поля корректны.
+bool ChessGame::parsePositionFields(std::string_view& text) {
+    std::string_view placement = nextField(text);
+    std::string_view side = nextField(text);
+    std::string_view castling = nextField(text);
+    std::string_view enPassant = nextField(text);
+
+    // Пустые поля заполняем заранее: цифра только сдвигает столбец
+    char parsed[SIZE][SIZE];
+    std::memset(parsed, '.', sizeof(parsed));
+    int row = 0, col = 0;
+    for (char c : placement) {
+        if (c == '/') {
+            if (col != SIZE || ++row >= SIZE) return false;
+            col = 0;
+        } else if (c >= '1' && c <= '8') {
+            int count = c - '0';
+            if (col + count > SIZE) return false;
+            col += count;
+        } else if (pieceIndex(c) >= 0 && col < SIZE) {
+            parsed[row][col++] = c;
+        } else {
+            return false;
+        }
+    }
+    if (row != SIZE - 1 || col != SIZE) return false;
+
+    if (side != "w" && side != "b") return false;
+
+    bool rights[4] = {false, false, false, false};  // K, Q, k, q
+    if (castling != "-") {
+        if (castling.empty()) return false;
+        for (char c : castling) {
+            switch (c) {
+                case 'K': rights[0] = true; break;
+                case 'Q': rights[1] = true; break;
+                case 'k': rights[2] = true; break;
+                case 'q': rights[3] = true; break;
+                default: return false;
+            }
+        }
+    }
+
+    // Поле взятия на проходе: за пешкой соперника, только что прошедшей его на два поля.
+    // Белые берут на 6-й горизонтали, чёрные - на 3-й; поле пусто, пешка стоит сразу за ним.
+    int epRow = -1, epCol = -1;
+    if (enPassant != "-") {
+        bool whiteToMove = (side == "w");
+        if (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' ||
+            enPassant[1] != (whiteToMove ? '6' : '3')) {
+            return false;
+        }
+        epRow = '8' - enPassant[1];
+        epCol = enPassant[0] - 'a';
+        int pawnRow = whiteToMove ? epRow + 1 : epRow - 1;
+        if (parsed[epRow][epCol] != '.' || parsed[pawnRow][epCol] != (whiteToMove ? 'p' : 'P')) {
+            return false;
+        }
+    }
+
+    std::memcpy(board, parsed, sizeof(board));
+    currentPlayer = (side == "w") ? 'W' : 'B';
+
+    // Права на рокировку в ChessGame - это флаги "король/ладья уже ходили"
+    whiteRookMoved[1] = !rights[0];
+    whiteRookMoved[0] = !rights[1];
+    blackRookMoved[1] = !rights[2];
+    blackRookMoved[0] = !rights[3];
+    whiteKingMoved = !rights[0] && !rights[1];
+    blackKingMoved = !rights[2] && !rights[3];
+
+    enPassantTargetRow = epRow;
+    enPassantTargetCol = epCol;
+
+    // clear() сохраняет ёмкость векторов: повторная загрузка не выделяет память
+    moveHistory.clear();
+    whiteCapturedPieces.clear();
+    blackCapturedPieces.clear();
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+
+    syncPosition();
+    return true;
+}
+
+bool ChessGame::loadFEN(std::string_view fen) {
+    if (!parsePositionFields(fen)) return false;
+
+    // Счётчики полуходов и ходов могут отсутствовать
+    std::string_view halfmove = nextField(fen);
+    std::string_view fullmove = nextField(fen);
+    int value = 0;
+    if (!halfmove.empty() &&
+        std::from_chars(halfmove.data(), halfmove.data() + halfmove.size(), value).ec == std::errc()) {
+        halfmoveClock = value;
+    }
+    if (!fullmove.empty() &&
+        std::from_chars(fullmove.data(), fullmove.data() + fullmove.size(), value).ec == std::errc() && value > 0) {
+        fullmoveNumber = value;
+    }
+    return true;
+}
+
+bool ChessGame::loadEPD(std::string_view epd, std::string_view* operations) {
+    if (!parsePositionFields(epd)) return false;
+    if (operations) {
+        size_t begin = 0;
+        while (begin < epd.size() && (epd[begin] == ' ' || epd[begin] == '\t')) ++begin;
+        *operations = epd.substr(begin);
+    }
+    return true;
+}
+
+void ChessGame::writePositionFields(std::string& out) const {
+    for (int row = 0; row < SIZE; ++row) {
+        int empty = 0;
+        for (int col = 0; col < SIZE; ++col) {
+            if (board[row][col] == '.') {
+                ++empty;
+                continue;
+            }
+            if (empty) out += static_cast<char>('0' + empty);
+            empty = 0;
+            out += board[row][col];
+        }
+        if (empty) out += static_cast<char>('0' + empty);
+        if (row != SIZE - 1) out += '/';
+    }
+
+    out += (currentPlayer == 'W') ? " w " : " b ";
+
+    int rights = position.castlingRights;
+    if (rights & WHITE_OO) out += 'K';
+    if (rights & WHITE_OOO) out += 'Q';
+    if (rights & BLACK_OO) out += 'k';
+    if (rights & BLACK_OOO) out += 'q';
+    if (!rights) out += '-';
+
+    out += ' ';
+    if (enPassantTargetRow == -1) {
+        out += '-';
+    } else {
+        out += static_cast<char>('a' + enPassantTargetCol);
+        out += static_cast<char>('8' - enPassantTargetRow);
+    }
+}
+
+std::string ChessGame::toFEN() const {
+    std::string out;
+    out.reserve(90);
+    writePositionFields(out);
+    out += ' ';
+    out += std::to_string(halfmoveClock);
+    out += ' ';
+    out += std::to_string(fullmoveNumber);
+    return out;
+}
+
+std::string ChessGame::toEPD() const {
+    std::string out;
+    out.reserve(80);
+    writePositionFields(out);
+    return out;
+}
+
+// Счётчик полуходов сбрасывают взятие и ход пешкой, номер хода растёт после хода чёрных
+void ChessGame::advanceMoveCounters(char piece, bool isCapture) {
+    if (isCapture || piece == 'P' || piece == 'p') halfmoveClock = 0;
+    else ++halfmoveClock;
+    if (piece >= 'a' && piece <= 'z') ++fullmoveNumber;
 }
 
 void ChessGame::copyBoard(const char srcBoard[SIZE][SIZE], char destBoard[SIZE][SIZE]) {
@@ -61,70 +351,98 @@ void ChessGame::copyBoard(const char srcBoard[SIZE][SIZE], char destBoard[SIZE][
     }
 }
 
-bool ChessGame::isInCheck(char kingChar, const char customBoard[SIZE][SIZE]) {
-    const char (*currentBoard)[SIZE] = (customBoard != nullptr) ? customBoard : board;
-    int kingRow = -1, kingCol = -1;
-
-    for (int i = 0; i < SIZE && kingRow == -1; ++i) {
+Bitboard ChessGame::occupancyOf(const char currentBoard[SIZE][SIZE]) const {
+    if (currentBoard == board) return position.occupied;
+    Bitboard occupied = 0;
+    for (int i = 0; i < SIZE; ++i) {
         for (int j = 0; j < SIZE; ++j) {
-            if (currentBoard[i][j] == kingChar) {
-                kingRow = i;
-                kingCol = j;
-                break;
-            }
+            if (currentBoard[i][j] != '.') occupied |= squareBB(makeSquare(i, j));
         }
     }
+    return occupied;
+}
 
-    if (kingRow == -1) {
+bool ChessGame::isInCheck(char kingChar, const char customBoard[SIZE][SIZE]) {
+    const Position* pos = &position;
+    Position temp;
+    if (customBoard != nullptr && customBoard != board) {
+        temp.setFromBoard(customBoard);
+        pos = &temp;
+    }
+
+    int kingColor = (kingChar == 'K') ? WHITE : BLACK;
+    int kingSquare = pos->kingSquare(kingColor);
+    if (kingSquare == -1) {
         // Король отсутствует
         return true;
     }
 
-    char opponentColor = (kingChar == 'K') ? 'B' : 'W';
-    return isSquareAttacked(kingRow, kingCol, opponentColor, currentBoard);
+    return pos->isAttacked(kingSquare, kingColor == WHITE ? BLACK : WHITE);
 }
 
 bool ChessGame::isKingPresent(char kingChar) {
-    for (int i = 0; i < SIZE; ++i) {
-        if (std::find(board[i], board[i] + SIZE, kingChar) != board[i] + SIZE) {
-            return true;
-        }
-    }
-    return false;
+    return position.kingSquare(kingChar == 'K' ? WHITE : BLACK) != -1;
 }
 
 bool ChessGame::isInCheckmate(char kingChar) {
     if (!isInCheck(kingChar)) {
         return false;
     }
+    // Мат - шах без единого легального хода
+    MoveList moves;
+    generateLegalMoves((kingChar == 'K') ? 'W' : 'B', moves);
+    return moves.empty();
+}
 
-    char playerColor = (kingChar == 'K') ? 'W' : 'B';
-    // Ищем ход, спасающий от мата
-    for (int fromRow = 0; fromRow < SIZE; ++fromRow) {
-        for (int fromCol = 0; fromCol < SIZE; ++fromCol) {
-            char piece = board[fromRow][fromCol];
-            if (piece == '.') continue;
-
-            if ((playerColor == 'W' && piece >= 'A' && piece <= 'Z') ||
-                (playerColor == 'B' && piece >= 'a' && piece <= 'z')) {
-                for (int toRow = 0; toRow < SIZE; ++toRow) {
-                    for (int toCol = 0; toCol < SIZE; ++toCol) {
-                        if (isValidMove(fromRow, fromCol, toRow, toCol, playerColor)) {
-                            // Есть ход - нет мата
-                            return false;
-                        }
-                    }
-                }
-            }
+bool ChessGame::isStalemate(char kingChar) {
+    // Пат - нет шаха и нет ни одного легального хода
+    if (!isKingPresent(kingChar) || isInCheck(kingChar)) {
+        return false;
+    }
+    MoveList moves;
+    generateLegalMoves((kingChar == 'K') ? 'W' : 'B', moves);
+    return moves.empty();
+}
+
+void ChessGame::historyMoves(std::vector<Move>& moves) const {
+    moves.clear();
+    moves.reserve(moveHistory.size());
+    Position replay = historyStart;
+    UndoInfo undo;
+    for (PackedMove move : moveHistory) {
+        moves.push_back(unpackMove(move, replay));
+        replay.makeMove(move, undo);
+    }
+}
+
+void ChessGame::generateLegalMoves(MoveList& moves) {
+    generateLegalMoves(currentPlayer, moves);
+}
+
+void ChessGame::generateLegalMoves(char playerColor, MoveList& moves) {
+    moves.clear();
+    int color = (playerColor == 'W') ? WHITE : BLACK;
+    const CheckInfo& info = checkInfoFor(color);
+
+    // Маски шахов и связок считаются один раз, дальше - только перебор битов
+    Bitboard ours = position.byColor[color];
+    while (ours) {
+        int from = popLsb(ours);
+        Bitboard targets = position.legalTargets(from, info);
+        while (targets) {
+            int to = popLsb(targets);
+            moves.add(position.encodeMove(from, to));
         }
     }
-    return true;
 }
 
-bool ChessGame::isStalemate(char kingChar) {
-    // Можно реализовать аналогично isInCheckmate, но проверяя отсутствие шаха
-    // Опустим детально, сейчас оставим false
-    return false;
+const CheckInfo& ChessGame::checkInfoFor(int color) {
+    if (!checkInfoValid[color] || checkInfoKey[color] != position.key) {
+        checkInfoCache[color] = position.checkInfo(color);
+        checkInfoKey[color] = position.key;
+        checkInfoValid[color] = true;
+    }
+    return checkInfoCache[color];
 }
 
 bool ChessGame::isValidMove(int fromRow, int fromCol, int toRow, int toCol, char playerColor, bool ignoreCheck, const char customBoard[SIZE][SIZE]) {
@@ -144,6 +462,22 @@ bool ChessGame::isValidMove(int fromRow, int fromCol, int toRow, int toCol, char
         if (playerColor=='B' && (targetPiece>='a' && targetPiece<='z')) return false;
     }
 
+    // Легальность проверяется масками шахов и связок, без выполнения хода на копии доски
+    if (!ignoreCheck) {
+        int color = (playerColor == 'W') ? WHITE : BLACK;
+        Bitboard target = squareBB(makeSquare(toRow, toCol));
+        if (currentBoard == board) {
+            return (position.legalTargets(makeSquare(fromRow, fromCol), checkInfoFor(color)) & target) != 0;
+        }
+        Position temp;
+        temp.setFromBoard(currentBoard);
+        temp.setCastlingRights(castlingRightsOf(currentBoard));
+        temp.setEpSquare((enPassantTargetRow == -1) ? -1 : makeSquare(enPassantTargetRow, enPassantTargetCol));
+        return (temp.legalTargets(makeSquare(fromRow, fromCol), temp.checkInfo(color)) & target) != 0;
+    }
+
+    // Дальше - только правила хода фигур, без учёта шаха (ignoreCheck)
+
     // Проверка на особый ход: рокировка
     if ((piece=='K' && playerColor=='W' && fromRow==7 && fromCol==4 && toRow==7 && (toCol==6||toCol==2))) {
         // Белая рокировка
@@ -158,12 +492,10 @@ bool ChessGame::isValidMove(int fromRow, int fromCol, int toRow, int toCol, char
             // [7][4] - старт короля, если он под шахом, уже invalidMove
             // [7][5] и [7][6] нельзя чтобы были атакованы
             char oppColor='B';
-            char temp[SIZE][SIZE];
-            copyBoard(currentBoard,temp);
             // Проверяем атаки на промежуточные клетки
-            if (isSquareAttacked(7,4,oppColor,temp)) return false; // Король не должен начинать под шахом
-            if (isSquareAttacked(7,5,oppColor,temp)) return false;
-            if (isSquareAttacked(7,6,oppColor,temp)) return false;
+            if (isSquareAttacked(7,4,oppColor,currentBoard)) return false; // Король не должен начинать под шахом
+            if (isSquareAttacked(7,5,oppColor,currentBoard)) return false;
+            if (isSquareAttacked(7,6,oppColor,currentBoard)) return false;
 
             // Допустима рокировка
         } else {
@@ -173,18 +505,13 @@ bool ChessGame::isValidMove(int fromRow, int fromCol, int toRow, int toCol, char
             if (currentBoard[7][1]!='.' || currentBoard[7][2]!='.'||currentBoard[7][3]!='.') return false;
 
             char oppColor='B';
-            char temp[SIZE][SIZE];
-            copyBoard(currentBoard,temp);
-            if (isSquareAttacked(7,4,oppColor,temp)) return false;
-            if (isSquareAttacked(7,3,oppColor,temp)) return false;
-            if (isSquareAttacked(7,2,oppColor,temp)) return false;
+            if (isSquareAttacked(7,4,oppColor,currentBoard)) return false;
+            if (isSquareAttacked(7,3,oppColor,currentBoard)) return false;
+            if (isSquareAttacked(7,2,oppColor,currentBoard)) return false;
 
             // Допустимо
         }
         // Если дошли сюда, рокировка допустима
-        if (!ignoreCheck) {
-            // Проверим, что после хода не остается шаха (уже проверили выше)
-        }
         return true;
     }
 
@@ -192,23 +519,21 @@ bool ChessGame::isValidMove(int fromRow, int fromCol, int toRow, int toCol, char
     if ((piece=='k' && playerColor=='B' && fromRow==0 && fromCol==4 && toRow==0 && (toCol==6||toCol==2))) {
         if (blackKingMoved) return false;
         char oppColor='W';
-        char temp[SIZE][SIZE];
-        copyBoard(currentBoard,temp);
 
         if (toCol==6) {
             // Короткая чёрная
             if (blackRookMoved[1]) return false;
             if (currentBoard[0][5]!='.'||currentBoard[0][6]!='.') return false;
-            if (isSquareAttacked(0,4,oppColor,temp)) return false;
-            if (isSquareAttacked(0,5,oppColor,temp)) return false;
-            if (isSquareAttacked(0,6,oppColor,temp)) return false;
+            if (isSquareAttacked(0,4,oppColor,currentBoard)) return false;
+            if (isSquareAttacked(0,5,oppColor,currentBoard)) return false;
+            if (isSquareAttacked(0,6,oppColor,currentBoard)) return false;
         } else {
             // Длинная чёрная
             if (blackRookMoved[0]) return false;
             if (currentBoard[0][1]!='.'||currentBoard[0][2]!='.'||currentBoard[0][3]!='.') return false;
-            if (isSquareAttacked(0,4,oppColor,temp)) return false;
-            if (isSquareAttacked(0,3,oppColor,temp)) return false;
-            if (isSquareAttacked(0,2,oppColor,temp)) return false;
+            if (isSquareAttacked(0,4,oppColor,currentBoard)) return false;
+            if (isSquareAttacked(0,3,oppColor,currentBoard)) return false;
+            if (isSquareAttacked(0,2,oppColor,currentBoard)) return false;
         }
         return true;
     }
@@ -238,16 +563,6 @@ bool ChessGame::isValidMove(int fromRow, int fromCol, int toRow, int toCol, char
             return false;
     }
 
-    // Проверка на шах, если ignoreCheck=false
-    if (!ignoreCheck) {
-        char tempBoard[SIZE][SIZE];
-        copyBoard(currentBoard,tempBoard);
-        tempBoard[toRow][toCol]=piece;
-        tempBoard[fromRow][fromCol]='.';
-        char kingChar=(playerColor=='W')?'K':'k';
-        if (isInCheck(kingChar,tempBoard)) return false;
-    }
-
     return true;
 }
 
@@ -255,43 +570,51 @@ bool ChessGame::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
     char piece = board[fromRow][fromCol];
     if (piece == '.') return false;
     char playerColor = (piece >= 'A' && piece <= 'Z') ? 'W' : 'B';
+    // Ход для истории упаковывается до изменения позиции
+    PackedMove packed = position.encodeMove(makeSquare(fromRow, fromCol), makeSquare(toRow, toCol));
 
     // Если это рокировка, после isValidMove уже всё проверено.
     if (piece == 'K' && playerColor=='W' && fromRow==7 && fromCol==4 && toRow==7 && (toCol==6||toCol==2)) {
         bool shortCastling = (toCol==6);
-        board[7][4]='.';
-        board[7][toCol]='K';
+        setSquare(7,4,'.');
+        setSquare(7,toCol,'K');
         if (shortCastling) {
-            board[7][7]='.';
-            board[7][5]='R';
+            setSquare(7,7,'.');
+            setSquare(7,5,'R');
             whiteRookMoved[1]=true;
         } else {
-            board[7][0]='.';
-            board[7][3]='R';
+            setSquare(7,0,'.');
+            setSquare(7,3,'R');
             whiteRookMoved[0]=true;
         }
         whiteKingMoved=true;
-        moveHistory.push_back({piece, fromRow, fromCol, toRow, toCol, playerColor});
+        moveHistory.push_back(packed);
+        advanceMoveCounters(piece,false);
         currentPlayer=(currentPlayer=='W')?'B':'W';
+        enPassantTargetRow=-1;enPassantTargetCol=-1;
+        syncPositionState();
         return true;
     }
 
     if (piece=='k' && playerColor=='B' && fromRow==0 && fromCol==4 && toRow==0 && (toCol==6||toCol==2)) {
         bool shortCastling=(toCol==6);
-        board[0][4]='.';
-        board[0][toCol]='k';
+        setSquare(0,4,'.');
+        setSquare(0,toCol,'k');
         if (shortCastling) {
-            board[0][7]='.';
-            board[0][5]='r';
+            setSquare(0,7,'.');
+            setSquare(0,5,'r');
             blackRookMoved[1]=true;
         } else {
-            board[0][0]='.';
-            board[0][3]='r';
+            setSquare(0,0,'.');
+            setSquare(0,3,'r');
             blackRookMoved[0]=true;
         }
         blackKingMoved=true;
-        moveHistory.push_back({piece, fromRow, fromCol, toRow, toCol, playerColor});
+        moveHistory.push_back(packed);
+        advanceMoveCounters(piece,false);
         currentPlayer=(currentPlayer=='W')?'B':'W';
+        enPassantTargetRow=-1;enPassantTargetCol=-1;
+        syncPositionState();
         return true;
     }
 
@@ -301,22 +624,26 @@ bool ChessGame::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
         // Проверим, совпадает ли это с en passant
         if (playerColor=='W' && fromRow==3 && toRow==2 && toRow==enPassantTargetRow && toCol==enPassantTargetCol) {
             // Белое взятие на проходе
-            board[toRow][toCol]=piece;
-            board[fromRow][fromCol]='.';
-            board[toRow+1][toCol]='.';
-            moveHistory.push_back({piece,fromRow,fromCol,toRow,toCol,playerColor});
+            setSquare(toRow,toCol,piece);
+            setSquare(fromRow,fromCol,'.');
+            setSquare(toRow+1,toCol,'.');
+            moveHistory.push_back(packed);
+            advanceMoveCounters(piece,true);
             currentPlayer=(currentPlayer=='W')?'B':'W';
             enPassantTargetRow=-1;enPassantTargetCol=-1;
+            syncPositionState();
             return true;
         }
         if (playerColor=='B' && fromRow==4 && toRow==5 && toRow==enPassantTargetRow && toCol==enPassantTargetCol) {
             // Чёрное взятие на проходе
-            board[toRow][toCol]=piece;
-            board[fromRow][fromCol]='.';
-            board[toRow-1][toCol]='.';
-            moveHistory.push_back({piece,fromRow,fromCol,toRow,toCol,playerColor});
+            setSquare(toRow,toCol,piece);
+            setSquare(fromRow,fromCol,'.');
+            setSquare(toRow-1,toCol,'.');
+            moveHistory.push_back(packed);
+            advanceMoveCounters(piece,true);
             currentPlayer=(currentPlayer=='W')?'B':'W';
             enPassantTargetRow=-1;enPassantTargetCol=-1;
+            syncPositionState();
             return true;
         }
     }
@@ -328,8 +655,8 @@ bool ChessGame::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
         else whiteCapturedPieces.push_back(captured);
     }
 
-    board[toRow][toCol]=piece;
-    board[fromRow][fromCol]='.';
+    setSquare(toRow,toCol,piece);
+    setSquare(fromRow,fromCol,'.');
 
     // Обновляем флаги
     if (piece=='K') whiteKingMoved=true;
@@ -350,14 +677,16 @@ bool ChessGame::movePiece(int fromRow, int fromCol, int toRow, int toCol) {
 
     // Превращение пешки
     if (piece=='P' && toRow==0) {
-        board[toRow][toCol]='Q';
+        setSquare(toRow,toCol,'Q');
     }
     if (piece=='p' && toRow==7) {
-        board[toRow][toCol]='q';
+        setSquare(toRow,toCol,'q');
     }
 
-    moveHistory.push_back({piece,fromRow,fromCol,toRow,toCol,playerColor});
+    moveHistory.push_back(packed);
+    advanceMoveCounters(piece,captured!='.');
     currentPlayer=(currentPlayer=='W')?'B':'W';
+    syncPositionState();
 
     return true;
 }
@@ -379,7 +708,7 @@ bool ChessGame::isValidPawnMove(int fromRow,int fromCol,int toRow,int toCol,char
                 return true;
             }
         }
-    } else if (abs(toCol - fromCol)==1 && (toRow - fromRow)==direction) {
+    } else if (pawnAttacks(makeSquare(fromRow,fromCol), playerColor=='W') & squareBB(makeSquare(toRow,toCol))) {
         // Диагональный ход
         if (target!='.' && ((playerColor=='W'&&target>=oppStart&&target<=oppEnd)||(playerColor=='B'&&target>='A'&&target<='Z'))) {
             return true; // Обычное взятие
@@ -398,65 +727,45 @@ bool ChessGame::isValidPawnMove(int fromRow,int fromCol,int toRow,int toCol,char
 
 bool ChessGame::isValidRookMove(int fromRow,int fromCol,int toRow,int toCol,const char currentBoard[SIZE][SIZE]) {
     if (fromRow!=toRow && fromCol!=toCol) return false;
-
-    int rStep=(toRow>fromRow)?1:((toRow<fromRow)?-1:0);
-    int cStep=(toCol>fromCol)?1:((toCol<fromCol)?-1:0);
-
-    int r=fromRow+rStep,c=fromCol+cStep;
-    while (r!=toRow || c!=toCol) {
-        if (currentBoard[r][c]!='.') return false;
-        r+=rStep; c+=cStep;
-    }
-    return true;
+    Bitboard attacks=rookAttacks(makeSquare(fromRow,fromCol),occupancyOf(currentBoard));
+    return (attacks & squareBB(makeSquare(toRow,toCol))) != 0;
 }
 
 bool ChessGame::isValidKnightMove(int fromRow,int fromCol,int toRow,int toCol) {
-    int dr=abs(toRow-fromRow), dc=abs(toCol-fromCol);
-    return (dr==2&&dc==1)||(dr==1&&dc==2);
+    return (knightAttacks(makeSquare(fromRow,fromCol)) & squareBB(makeSquare(toRow,toCol))) != 0;
 }
 
 bool ChessGame::isValidBishopMove(int fromRow,int fromCol,int toRow,int toCol,const char currentBoard[SIZE][SIZE]) {
     if (abs(toRow-fromRow)!=abs(toCol-fromCol)) return false;
-    int rStep=(toRow>fromRow)?1:-1;
-    int cStep=(toCol>fromCol)?1:-1;
-    int r=fromRow+rStep,c=fromCol+cStep;
-    while (r!=toRow && c!=toCol) {
-        if (currentBoard[r][c]!='.') return false;
-        r+=rStep;c+=cStep;
-    }
-    return true;
+    Bitboard attacks=bishopAttacks(makeSquare(fromRow,fromCol),occupancyOf(currentBoard));
+    return (attacks & squareBB(makeSquare(toRow,toCol))) != 0;
 }
 
 bool ChessGame::isValidQueenMove(int fromRow,int fromCol,int toRow,int toCol,const char currentBoard[SIZE][SIZE]) {
-    return isValidRookMove(fromRow,fromCol,toRow,toCol,currentBoard)||
-           isValidBishopMove(fromRow,fromCol,toRow,toCol,currentBoard);
+    Bitboard attacks=queenAttacks(makeSquare(fromRow,fromCol),occupancyOf(currentBoard));
+    return (attacks & squareBB(makeSquare(toRow,toCol))) != 0;
 }
 
 bool ChessGame::isValidKingMove(int fromRow,int fromCol,int toRow,int toCol,const char currentBoard[SIZE][SIZE]) {
-    int dRow=abs(toRow-fromRow), dCol=abs(toCol-fromCol);
-    // Обычный ход короля: 1 клетка в любую сторону
-    if (dRow<=1 && dCol<=1) return true;
-    // Если король двигается на 2 клетки по горизонтали - это либо ошибка, либо рокировка,
-    // но рокировку мы проверяем отдельно в isValidMove() до этого блока.
-    return false;
+    // Обычный ход короля: 1 клетка в любую сторону.
+    // Рокировку мы проверяем отдельно в isValidMove() до этого блока.
+    return (kingAttacks(makeSquare(fromRow,fromCol)) & squareBB(makeSquare(toRow,toCol))) != 0;
 }
 
 void ChessGame::calculatePossibleMoves(int fromRow,int fromCol,char playerColor,std::vector<std::pair<int,int>>& moves) {
     moves.clear();
-    for (int tr=0; tr<SIZE; tr++) {
-        for (int tc=0; tc<SIZE; tc++) {
-            if (isValidMove(fromRow, fromCol, tr, tc, playerColor)) {
-                moves.push_back({tr,tc});
-            }
+    MoveList legal;
+    generateLegalMoves(playerColor, legal);
+    int from = makeSquare(fromRow, fromCol);
+    for (PackedMove move : legal) {
+        if (moveFrom(move) == from) {
+            moves.push_back({squareRow(moveTo(move)), squareCol(moveTo(move))});
         }
     }
 }
 
 void ChessGame::findKingPosition(char kingChar,int &kingRow,int &kingCol) {
-    kingRow=-1;kingCol=-1;
-    for (int i=0;i<SIZE && kingRow==-1;i++) {
-        for (int j=0;j<SIZE;j++) {
-            if (board[i][j]==kingChar) {kingRow=i;kingCol=j;break;}
-        }
-    }
-}
\ No newline at end of file
+    int kingSquare=position.kingSquare(kingChar=='K'?WHITE:BLACK);
+    kingRow=(kingSquare==-1)?-1:squareRow(kingSquare);
+    kingCol=(kingSquare==-1)?-1:squareCol(kingSquare);
+}
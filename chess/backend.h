@@ -1,10 +1,14 @@
 #pragma once
 
 #include <vector>
+#include <string>
+#include <string_view>
 #include <utility> // для std::pair
 #include <algorithm> // для std::fill
 #include <iostream> // при необходимости
 
+#include "position.h"
+
 const int SIZE = 8;
 
 enum GameMode {
@@ -12,6 +16,7 @@ enum GameMode {
     AGAINST_FRIEND
 };
 
+// Развёрнутый ход для интерфейса. Движок, списки ходов и история хранят PackedMove (move.h).
 struct Move {
     char piece;       // Фигура, которая ходит
     int fromRow, fromCol; // Откуда
@@ -19,6 +24,30 @@ struct Move {
     char playerColor;     // 'W' или 'B'
 };
 
+// Перевод между упакованным и развёрнутым ходом. pos - позиция до хода.
+Move unpackMove(PackedMove move, const Position& pos);
+PackedMove packMove(const Move& move, const Position& pos);
+
+// Список ходов фиксированной ёмкости на стеке: генерация ходов без выделения памяти
+const int MAX_MOVES = 256;
+
+struct MoveList {
+    PackedMove moves[MAX_MOVES];
+    int count = 0;
+
+    void add(PackedMove move) { moves[count++] = move; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { count = 0; }
+
+    PackedMove& operator[](int i) { return moves[i]; }
+    const PackedMove& operator[](int i) const { return moves[i]; }
+    PackedMove* begin() { return moves; }
+    PackedMove* end() { return moves + count; }
+    const PackedMove* begin() const { return moves; }
+    const PackedMove* end() const { return moves + count; }
+};
+
 class ChessGame {
 public:
     ChessGame(GameMode mode);
@@ -32,11 +61,41 @@ public:
 
     bool movePiece(int fromRow, int fromCol, int toRow, int toCol);
 
-    bool isSquareAttacked(int row, int col, char opponentColor, const char boardState[SIZE][SIZE]);
+    // Ставит фигуру (или '.') на клетку, обновляя и board, и position
+    void setSquare(int row, int col, char piece);
+
+    // Перестраивает position по board. Нужно вызывать после прямой записи в board.
+    void syncPosition();
+
+    // Переносит в position права на рокировку, поле взятия на проходе и очередь хода
+    void syncPositionState();
+
+    // 64-битный ключ Zobrist текущей позиции
+    uint64_t positionKey() const { return position.key; }
+
+    // Загрузка и сохранение позиции в FEN. Разбор идёт по string_view без выделения памяти;
+    // при ошибке формата игра не меняется и возвращается false. Счётчики ходов необязательны.
+    bool loadFEN(std::string_view fen);
+    std::string toFEN() const;
+
+    // EPD: четыре поля позиции и операции вида "bm e4; id \"WAC.001\";".
+    // Если operations задан, он указывает на операции внутри строки epd.
+    bool loadEPD(std::string_view epd, std::string_view* operations = nullptr);
+    std::string toEPD() const;
+
+    // Атакована ли клетка фигурами цвета opponentColor. Проверка останавливается на первом нападающем.
+    bool isSquareAttacked(int row, int col, char opponentColor, const char boardState[SIZE][SIZE] = nullptr);
+    // Все фигуры цвета opponentColor, атакующие клетку (например, для подсчёта шахующих)
+    Bitboard attackersOf(int row, int col, char opponentColor, const char boardState[SIZE][SIZE] = nullptr);
+    // Висит ли фигура на клетке: соперник выигрывает на ней материал разменом (SEE)
+    bool isHanging(int row, int col) const;
 
     // Копирование доски
     void copyBoard(const char srcBoard[SIZE][SIZE], char destBoard[SIZE][SIZE]);
 
+    // Маска занятых клеток доски (для собственной доски берётся из position)
+    Bitboard occupancyOf(const char currentBoard[SIZE][SIZE]) const;
+
     // Проверка шаха, мата, пата
     bool isInCheck(char kingChar, const char customBoard[SIZE][SIZE] = nullptr);
     bool isInCheckmate(char kingChar);
@@ -47,6 +106,11 @@ public:
     // Поиск позиции короля
     void findKingPosition(char kingChar, int& kingRow, int& kingCol);
 
+    // Все легальные ходы стороны playerColor (по умолчанию - текущего игрока) на собственной доске.
+    // Список очищается перед заполнением.
+    void generateLegalMoves(MoveList& moves);
+    void generateLegalMoves(char playerColor, MoveList& moves);
+
     // Вычисление возможных ходов для фигуры
     void calculatePossibleMoves(int fromRow, int fromCol, char playerColor, std::vector<std::pair<int,int>>& moves);
 
@@ -62,10 +126,14 @@ public:
     GameMode gameMode;
 
     char board[SIZE][SIZE]; // Шахматная доска
+    Position position;      // Битовое представление board, для быстрых запросов атак и королей
 
     std::vector<char> whiteCapturedPieces; // Захваченные белые фигуры (чёрными)
     std::vector<char> blackCapturedPieces; // Захваченные чёрные фигуры (белыми)
-    std::vector<Move> moveHistory;         // История ходов
+    std::vector<PackedMove> moveHistory;   // История ходов от позиции historyStart
+
+    // История в развёрнутом виде (с фигурами) для интерфейса: ходы переигрываются от historyStart
+    void historyMoves(std::vector<Move>& moves) const;
 
     bool whiteKingMoved;         // Двигался ли белый король
     bool blackKingMoved;         // Двигался ли чёрный король
@@ -76,4 +144,22 @@ public:
     int enPassantTargetCol;
 
     char currentPlayer;          // Текущий игрок ('W' или 'B')
+
+    int halfmoveClock;           // Полуходы после последнего взятия или хода пешкой
+    int fullmoveNumber;          // Номер хода, растёт после хода чёрных
+
+private:
+    Position historyStart;  // Позиция, с которой начинается moveHistory
+
+    // Шахи и связки текущей позиции для каждого цвета; пересчитываются при смене ключа
+    CheckInfo checkInfoCache[2];
+    uint64_t checkInfoKey[2];
+    bool checkInfoValid[2];
+    const CheckInfo& checkInfoFor(int color);
+
+    int castlingRightsOf(const char currentBoard[SIZE][SIZE]) const;
+
+    bool parsePositionFields(std::string_view& text);
+    void writePositionFields(std::string& out) const;
+    void advanceMoveCounters(char piece, bool isCapture);
 };
\ No newline at end of file
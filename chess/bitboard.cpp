@@ -0,0 +1,136 @@
+// bitboard.cpp
+
+#include "bitboard.h"
+
+// Таблицы атак коротких фигур посчитаны при компиляции: проверяем несколько клеток
+static_assert(knightAttacks(0) == (squareBB(10) | squareBB(17)), "knight a8");
+static_assert(knightAttacks(63) == (squareBB(46) | squareBB(53)), "knight h1");
+static_assert(kingAttacks(7) == (squareBB(6) | squareBB(14) | squareBB(15)), "king h8");
+static_assert(pawnAttacks(52, true) == (squareBB(43) | squareBB(45)), "white pawn e2");
+static_assert(pawnAttacks(8, false) == squareBB(17), "black pawn a7");
+
+// Заливка луча до первой занятой клетки включительно (dumb7fill).
+// Используется только для построения таблиц при инициализации.
+template <Bitboard (*Shift)(Bitboard)>
+static Bitboard slide(Bitboard from, Bitboard empty) {
+    Bitboard flood = from;
+    Bitboard gen = from;
+    for (int i = 0; i < 6; ++i) {
+        gen = Shift(gen) & empty;
+        flood |= gen;
+    }
+    return Shift(flood);
+}
+
+static Bitboard slowRookAttacks(int square, Bitboard occupied) {
+    Bitboard from = squareBB(square);
+    Bitboard empty = ~occupied;
+    return slide<shiftNorth>(from, empty) | slide<shiftSouth>(from, empty) |
+           slide<shiftEast>(from, empty) | slide<shiftWest>(from, empty);
+}
+
+static Bitboard slowBishopAttacks(int square, Bitboard occupied) {
+    Bitboard from = squareBB(square);
+    Bitboard empty = ~occupied;
+    return slide<shiftNorthEast>(from, empty) | slide<shiftNorthWest>(from, empty) |
+           slide<shiftSouthEast>(from, empty) | slide<shiftSouthWest>(from, empty);
+}
+
+Magic rookMagics[64];
+Magic bishopMagics[64];
+
+static Bitboard rookTable[0x19000];   // 102400 записей на все клетки
+static Bitboard bishopTable[0x1480];  // 5248 записей на все клетки
+
+// Магические множители подобраны заранее перебором разреженных случайных чисел
+// под нумерацию клеток из bitboard.h (a8 = 0, h1 = 63).
+static const Bitboard rookMagicNumbers[64] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL,
+};
+static const Bitboard bishopMagicNumbers[64] = {
+    0x10102002004A1420ULL, 0x8020040400584008ULL, 0x10510800811201C8ULL, 0x5204042080000088ULL,
+    0x2204106880000002ULL, 0x1401042004000000ULL, 0x0400880410042004ULL, 0x0028208200A02020ULL,
+    0x1500241990010E00ULL, 0x8001200182020A40ULL, 0x40004101030B0000ULL, 0x8002041042000100ULL,
+    0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020A00ULL, 0x8000088400880520ULL,
+    0x0405004010040100ULL, 0x1005823210040108ULL, 0x2708008102040011ULL, 0x4048200404009100ULL,
+    0x0018104101400024ULL, 0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+    0x0006E080100C3040ULL, 0x0501044A11041800ULL, 0x9020300008004045ULL, 0x0894080000220040ULL,
+    0x1001010083104000ULL, 0x5004030040900080ULL, 0x000400422C012400ULL, 0x0002128698404812ULL,
+    0x1010108404900440ULL, 0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+    0xA010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL, 0x802A02020000B098ULL,
+    0x0009015090004060ULL, 0x4000821082081001ULL, 0x0100210040420800ULL, 0x0800004010488A00ULL,
+    0x2000081104004040ULL, 0x4C8E029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+    0x0000822802400008ULL, 0x00008A0101600000ULL, 0x3040003412080021ULL, 0x3040290220884800ULL,
+    0x4A1500401041004AULL, 0x8010200282020781ULL, 0x0020203142209091ULL, 0x0070300600902110ULL,
+    0x0040808800B62048ULL, 0x0000810400C44420ULL, 0x00080400440C0441ULL, 0x8340080020840411ULL,
+    0x0000000104208200ULL, 0x0000800810D00080ULL, 0x0400530411080200ULL, 0x4040702400932244ULL,
+};
+
+static void initMagics(Magic magics[64], Bitboard* table, const Bitboard magicNumbers[64],
+                       Bitboard (*slowAttacks)(int, Bitboard)) {
+    for (int square = 0; square < 64; ++square) {
+        Magic& m = magics[square];
+
+        // Крайние клетки не влияют на атаки, если фигура не стоит на этом крае
+        Bitboard edges = ((ROW_0_BB | ROW_7_BB) & ~(ROW_0_BB << (8 * squareRow(square)))) |
+                         ((FILE_A_BB | FILE_H_BB) & ~(FILE_A_BB << squareCol(square)));
+        m.mask = slowAttacks(square, 0) & ~edges;
+        m.magic = magicNumbers[square];
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = (square == 0) ? table : magics[square - 1].attacks + (1 << (64 - magics[square - 1].shift));
+
+        // Перебираем все подмножества маски (Carry-Rippler) и заполняем таблицу
+        Bitboard b = 0;
+        do {
+            m.attacks[m.index(b)] = slowAttacks(square, b);
+            b = (b - m.mask) & m.mask;
+        } while (b);
+    }
+}
+
+Bitboard betweenBB[64][64];
+Bitboard lineBB[64][64];
+
+// Линии строятся по атакам дальнобойных фигур с пустой доски:
+// пересечение лучей из a и из b даёт отрезок между ними
+static void initLines() {
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            betweenBB[a][b] = lineBB[a][b] = 0;
+            if (a == b) continue;
+            Bitboard ab = squareBB(a) | squareBB(b);
+            if (rookAttacks(a, 0) & squareBB(b)) {
+                lineBB[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | ab;
+                betweenBB[a][b] = rookAttacks(a, squareBB(b)) & rookAttacks(b, squareBB(a));
+            } else if (bishopAttacks(a, 0) & squareBB(b)) {
+                lineBB[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | ab;
+                betweenBB[a][b] = bishopAttacks(a, squareBB(b)) & bishopAttacks(b, squareBB(a));
+            }
+        }
+    }
+}
+
+namespace {
+struct MagicInitializer {
+    MagicInitializer() {
+        initMagics(rookMagics, rookTable, rookMagicNumbers, slowRookAttacks);
+        initMagics(bishopMagics, bishopTable, bishopMagicNumbers, slowBishopAttacks);
+        initLines();
+    }
+} magicInitializer;
+}
@@ -0,0 +1,149 @@
+// bitboard.h
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// На процессорах с BMI2 индекс в таблице атак считается инструкцией PEXT,
+// иначе используется умножение на магическое число.
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define USE_PEXT
+#endif
+
+// Битовая доска: бит с номером square = row * 8 + col.
+// Нумерация совпадает с ChessGame::board: row 0 - восьмая горизонталь (чёрные),
+// row 7 - первая горизонталь (белые), col 0 - вертикаль A.
+typedef uint64_t Bitboard;
+
+const Bitboard FILE_A_BB = 0x0101010101010101ULL;
+const Bitboard FILE_B_BB = FILE_A_BB << 1;
+const Bitboard FILE_G_BB = FILE_A_BB << 6;
+const Bitboard FILE_H_BB = FILE_A_BB << 7;
+const Bitboard ROW_0_BB = 0xFFULL;         // Восьмая горизонталь
+const Bitboard ROW_7_BB = 0xFFULL << 56;   // Первая горизонталь
+
+inline int makeSquare(int row, int col) { return row * 8 + col; }
+inline int squareRow(int square) { return square >> 3; }
+inline int squareCol(int square) { return square & 7; }
+constexpr Bitboard squareBB(int square) { return 1ULL << square; }
+
+inline int popCount(Bitboard b) {
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(b));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// Номер младшего установленного бита (b != 0)
+inline int lsb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+// Извлекает младший бит и снимает его с доски
+inline int popLsb(Bitboard& b) {
+    int square = lsb(b);
+    b &= b - 1;
+    return square;
+}
+
+// Сдвиги на одно поле. "Север" - в сторону восьмой горизонтали (row уменьшается).
+constexpr Bitboard shiftNorth(Bitboard b) { return b >> 8; }
+constexpr Bitboard shiftSouth(Bitboard b) { return b << 8; }
+constexpr Bitboard shiftEast(Bitboard b) { return (b << 1) & ~FILE_A_BB; }
+constexpr Bitboard shiftWest(Bitboard b) { return (b >> 1) & ~FILE_H_BB; }
+constexpr Bitboard shiftNorthEast(Bitboard b) { return (b >> 7) & ~FILE_A_BB; }
+constexpr Bitboard shiftNorthWest(Bitboard b) { return (b >> 9) & ~FILE_H_BB; }
+constexpr Bitboard shiftSouthEast(Bitboard b) { return (b << 9) & ~FILE_A_BB; }
+constexpr Bitboard shiftSouthWest(Bitboard b) { return (b << 7) & ~FILE_H_BB; }
+
+// Поля, которые бьют пешки из множества pawns (isWhite - цвет пешек)
+constexpr Bitboard pawnAttacksBB(Bitboard pawns, bool isWhite) {
+    return isWhite ? (shiftNorthEast(pawns) | shiftNorthWest(pawns))
+                   : (shiftSouthEast(pawns) | shiftSouthWest(pawns));
+}
+
+// Атаки коня, короля и пешек не зависят от других фигур: таблицы на все 64 клетки
+// считаются при компиляции, и генерация их ходов - один поиск в таблице
+struct LeaperAttacks {
+    Bitboard knight[64];
+    Bitboard king[64];
+    Bitboard pawn[2][64];  // [0] - белые пешки, [1] - чёрные
+};
+
+constexpr LeaperAttacks makeLeaperAttacks() {
+    LeaperAttacks t{};
+    for (int square = 0; square < 64; ++square) {
+        Bitboard b = squareBB(square);
+        Bitboard h1 = shiftEast(b) | shiftWest(b);
+        Bitboard h2 = shiftEast(shiftEast(b)) | shiftWest(shiftWest(b));
+        t.knight[square] = shiftNorth(shiftNorth(h1)) | shiftSouth(shiftSouth(h1)) |
+                           shiftNorth(h2) | shiftSouth(h2);
+
+        Bitboard row = b | h1;
+        t.king[square] = (row | shiftNorth(row) | shiftSouth(row)) & ~b;
+
+        t.pawn[0][square] = pawnAttacksBB(b, true);
+        t.pawn[1][square] = pawnAttacksBB(b, false);
+    }
+    return t;
+}
+
+inline constexpr LeaperAttacks leaperAttacks = makeLeaperAttacks();
+
+constexpr Bitboard knightAttacks(int square) { return leaperAttacks.knight[square]; }
+constexpr Bitboard kingAttacks(int square) { return leaperAttacks.king[square]; }
+constexpr Bitboard pawnAttacks(int square, bool isWhite) { return leaperAttacks.pawn[isWhite ? 0 : 1][square]; }
+
+// Магическая таблица атак дальнобойной фигуры для одной клетки
+struct Magic {
+    Bitboard mask;      // Клетки, от которых зависят атаки (без краёв доски)
+    Bitboard magic;     // Магический множитель
+    Bitboard* attacks;  // Начало участка общей таблицы атак для этой клетки
+    unsigned shift;     // 64 - число бит в маске
+
+    unsigned index(Bitboard occupied) const {
+#if defined(USE_PEXT)
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Magic rookMagics[64];
+extern Magic bishopMagics[64];
+
+// Атаки дальнобойных фигур с учётом блокирующих фигур occupied: один поиск в таблице
+inline Bitboard rookAttacks(int square, Bitboard occupied) {
+    const Magic& m = rookMagics[square];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard bishopAttacks(int square, Bitboard occupied) {
+    const Magic& m = bishopMagics[square];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int square, Bitboard occupied) {
+    return rookAttacks(square, occupied) | bishopAttacks(square, occupied);
+}
+
+// Клетки строго между a и b, если они на одной линии (иначе 0)
+extern Bitboard betweenBB[64][64];
+// Вся линия (горизонталь, вертикаль или диагональ) через a и b, если они на одной линии (иначе 0)
+extern Bitboard lineBB[64][64];
+
+#endif // BITBOARD_H
@@ -0,0 +1,128 @@
+// book.cpp
+
+#include "book.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char BOOK_MAGIC[8] = {'C', 'H', 'B', 'O', 'O', 'K', '1', '\0'};
+
+OpeningBook::OpeningBook()
+        : mapping(nullptr), mappedSize(0),
+#ifdef _WIN32
+          fileHandle(nullptr), mappingHandle(nullptr),
+#endif
+          entries(nullptr), count(0) {
+}
+
+OpeningBook::~OpeningBook() {
+    close();
+}
+
+bool OpeningBook::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(BookHeader)) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = map ? MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (map) CloseHandle(map);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = map;
+    mapping = view;
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(BookHeader)) {
+        ::close(fd);
+        return false;
+    }
+    // Отображение разделяемое: страницы книги в кэше ОС общие для всех процессов
+    void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // Отображение держит файл само
+    if (view == MAP_FAILED) return false;
+    mapping = view;
+    mappedSize = static_cast<size_t>(st.st_size);
+#endif
+
+    // Проверяем только заголовок и размер: записи читаются прямо из отображения
+    const BookHeader* header = static_cast<const BookHeader*>(mapping);
+    size_t available = (mappedSize - sizeof(BookHeader)) / sizeof(BookEntry);
+    if (std::memcmp(header->magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0 || header->count > available) {
+        close();
+        return false;
+    }
+    entries = reinterpret_cast<const BookEntry*>(header + 1);
+    count = static_cast<size_t>(header->count);
+    return true;
+}
+
+void OpeningBook::close() {
+    if (mapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping);
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        fileHandle = mappingHandle = nullptr;
+#else
+        munmap(mapping, mappedSize);
+#endif
+    }
+    mapping = nullptr;
+    mappedSize = 0;
+    entries = nullptr;
+    count = 0;
+}
+
+size_t OpeningBook::probe(uint64_t key, const BookEntry*& first) const {
+    first = nullptr;
+    if (!entries) return 0;
+
+    const BookEntry* end = entries + count;
+    const BookEntry* begin = std::lower_bound(entries, end, key,
+            [](const BookEntry& entry, uint64_t k) { return entry.key < k; });
+    const BookEntry* last = begin;
+    while (last != end && last->key == key) ++last;
+    if (begin == last) return 0;
+    first = begin;
+    return static_cast<size_t>(last - begin);
+}
+
+PackedMove OpeningBook::pickMove(uint64_t key, uint32_t random) const {
+    const BookEntry* first;
+    size_t n = probe(key, first);
+    if (n == 0) return NO_MOVE;
+
+    uint32_t total = 0;
+    for (size_t i = 0; i < n; ++i) total += first[i].weight;
+    if (total == 0) return first[0].move;
+
+    // Точка в [0, total): ход, на отрезок веса которого она попала
+    uint32_t point = random % total;
+    for (size_t i = 0; i < n; ++i) {
+        if (point < first[i].weight) return first[i].move;
+        point -= first[i].weight;
+    }
+    return first[n - 1].move;
+}
@@ -0,0 +1,67 @@
+// book.h
+
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "move.h"
+
+// Двоичная дебютная книга: заголовок и записи, отсортированные по ключу Zobrist позиции.
+// Файл отображается в память как есть и не разбирается при открытии, поэтому
+// одну книгу только для чтения делят все процессы игры. Порядок байтов - родной (little-endian).
+struct BookHeader {
+    char magic[8];   // BOOK_MAGIC
+    uint64_t count;  // Число записей после заголовка
+};
+
+// Запись книги: 16 байт. У позиции может быть несколько записей подряд - по одной на ход.
+struct BookEntry {
+    uint64_t key;     // Position::key
+    PackedMove move;
+    uint16_t weight;  // Чем больше, тем чаще ход выбирается
+    uint32_t reserved;
+};
+
+static_assert(sizeof(BookHeader) == 16, "BookHeader layout");
+static_assert(sizeof(BookEntry) == 16, "BookEntry layout");
+
+extern const char BOOK_MAGIC[8];
+
+class OpeningBook {
+public:
+    OpeningBook();
+    ~OpeningBook();
+
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    // Отображает файл в память; при ошибке или неверном формате книга остаётся закрытой
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return entries != nullptr; }
+    size_t size() const { return count; }
+
+    // Записи позиции: first указывает на первую, возвращается их число (0 - позиции нет в книге).
+    // Поиск двоичный по отсортированным ключам.
+    size_t probe(uint64_t key, const BookEntry*& first) const;
+
+    // Ход позиции, выбранный с вероятностью, пропорциональной весу; random - любое случайное число.
+    // NO_MOVE, если позиции нет в книге.
+    PackedMove pickMove(uint64_t key, uint32_t random) const;
+
+private:
+    void* mapping;      // Начало отображения
+    size_t mappedSize;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+    const BookEntry* entries;
+    size_t count;
+};
+
+#endif // BOOK_H
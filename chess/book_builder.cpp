@@ -0,0 +1,69 @@
+// book_builder.cpp
+//
+// Сборка двоичной дебютной книги (book.h) из партий в PGN.
+// Из каждой партии берутся первые ходы; вес хода - сумма очков сделавшей его стороны
+// по всем партиям, где он встретился: победа 2, ничья 1, поражение 0, неизвестный итог 1.
+// Ходы с нулевым весом в книгу не попадают.
+//
+//   book_builder [-plies N] <book.bin> <games.pgn>...
+
+#include "book.h"
+#include "pgn.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    int plies = 20;
+    int arg = 1;
+    if (arg + 1 < argc && std::string(argv[arg]) == "-plies") {
+        plies = std::atoi(argv[arg + 1]);
+        arg += 2;
+    }
+    if (argc - arg < 2 || plies < 1) {
+        std::cout << "Использование: book_builder [-plies N] <book.bin> <games.pgn>..." << std::endl;
+        return 2;
+    }
+    std::string output = argv[arg++];
+
+    BookWeights weights;
+    int games = 0;
+    for (; arg < argc; ++arg) {
+        std::ifstream in(argv[arg]);
+        if (!in) {
+            std::cerr << "Не удалось открыть " << argv[arg] << std::endl;
+            return 1;
+        }
+        games += readPGN(in, plies, weights);
+    }
+
+    // map уже упорядочен по ключу: записи одной позиции идут подряд
+    std::vector<BookEntry> entries;
+    for (const auto& item : weights) {
+        if (item.second == 0) continue;
+        BookEntry entry;
+        entry.key = item.first.first;
+        entry.move = item.first.second;
+        entry.weight = static_cast<uint16_t>(std::min<uint32_t>(item.second, 0xFFFF));
+        entry.reserved = 0;
+        entries.push_back(entry);
+    }
+
+    BookHeader header;
+    std::copy(BOOK_MAGIC, BOOK_MAGIC + sizeof(BOOK_MAGIC), header.magic);
+    header.count = entries.size();
+
+    std::ofstream out(output, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(BookEntry));
+    if (!out) {
+        std::cerr << "Ошибка записи " << output << std::endl;
+        return 1;
+    }
+
+    std::cout << games << " партий, " << entries.size() << " записей -> " << output << std::endl;
+    return 0;
+}
@@ -6,13 +6,139 @@
 #include <FL/Fl.H>
 #include <FL/fl_ask.H>
 #include <algorithm>   // Для std::max и std::min
-#include <cstdlib>     // Для rand()
 #include <iostream>    // Для отладочных выводов
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Ценность фигуры для упорядочивания взятий
+static int orderValue(char piece) {
+    switch (tolower(piece)) {
+        case 'p': return 1;
+        case 'n': return 3;
+        case 'b': return 3;
+        case 'r': return 5;
+        case 'q': return 9;
+        case 'k': return 20;
+        default:  return 0;
+    }
+}
+
+// Материальная ценность в тех же единицах, что и evaluateBoard
+static int materialValue(char piece) {
+    switch (tolower(piece)) {
+        case 'p': return 100;
+        case 'n': return 320;
+        case 'b': return 330;
+        case 'r': return 500;
+        case 'q': return 900;
+        default:  return 0;
+    }
+}
+
+static bool isPromotionMove(PackedMove move) {
+    return moveKind(move) == MOVE_PROMOTION;
+}
+
+// Ход в координатной записи: клетка откуда, клетка куда и буква фигуры превращения
+static std::string moveName(PackedMove move) {
+    int from = moveFrom(move);
+    int to = moveTo(move);
+    std::string name;
+    name += static_cast<char>('a' + squareCol(from));
+    name += static_cast<char>('8' - squareRow(from));
+    name += static_cast<char>('a' + squareCol(to));
+    name += static_cast<char>('8' - squareRow(to));
+    if (moveKind(move) == MOVE_PROMOTION) name += "nbrq"[movePromotion(move)];
+    return name;
+}
+
+static std::string formatPV(const PackedMove* pv, int length) {
+    std::string text;
+    for (int i = 0; i < length; ++i) {
+        if (i > 0) text += ' ';
+        text += moveName(pv[i]);
+    }
+    return text;
+}
 
 BotPlayer::BotPlayer(ChessGame* game, ChessBoard* board)
-        : chessGame(game), chessBoard(board) {
-    // Устанавливаем максимальную глубину для алгоритма minimax
-    maxDepth = 3; // Можно изменить для настройки производительности
+        : chessGame(game), chessBoard(board),
+          threadId(0), stopSignal(nullptr), orderingSeed(0), rootMove(NO_MOVE), completedDepth(0),
+          ply(0), nodes(0), qnodes(0),
+          nullMoveTries(0), nullMoveCutoffs(0), lmrReductions(0), lmrResearches(0),
+          pvsResearches(0), aspirationFails(0), pawnTable(nullptr),
+          softTimeMs(0), hardTimeMs(0), stopped(false), rootDepth(0),
+          previousPVLength(0), followPV(false), searchPVLength(0) {
+    rootBest.move = NO_MOVE;
+    rootBest.score = 0;
+    searchResult = rootBest;
+    cancelRequested = false;
+    resultPosted = false;
+}
+
+BotPlayer::~BotPlayer() {
+    if (worker.joinable()) {
+        cancelRequested = true;
+        worker.join();
+    }
+}
+
+int BotPlayer::searchThreads = 1;
+
+void BotPlayer::setThreadCount(int threads) {
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    searchThreads = threads;
+}
+
+TranspositionTable& BotPlayer::transpositionTable() {
+    static TranspositionTable table(16);
+    return table;
+}
+
+void BotPlayer::setHashSizeMB(size_t sizeMB) {
+    transpositionTable().resize(sizeMB);
+}
+
+PawnTable& BotPlayer::pawnTableFor(int thread) {
+    static std::unique_ptr<PawnTable> tables[MAX_THREADS];
+    if (!tables[thread]) tables[thread].reset(new PawnTable());
+    return *tables[thread];
+}
+
+std::vector<std::unique_ptr<BotPlayer>>& BotPlayer::searchHelpers() {
+    static std::vector<std::unique_ptr<BotPlayer>> helpers;
+    return helpers;
+}
+
+OpeningBook& BotPlayer::openingBook() {
+    static OpeningBook book;
+    return book;
+}
+
+// Ход из книги для позиции поиска. Ход проверяется на легальность:
+// совпадение ключа Zobrist ещё не гарантирует, что это та же позиция.
+PackedMove BotPlayer::probeBook() {
+    if (!openingBook().isOpen()) return NO_MOVE;
+
+    static thread_local std::mt19937 random(std::random_device{}());
+    PackedMove move = openingBook().pickMove(position.key, static_cast<uint32_t>(random()));
+    if (move == NO_MOVE) return NO_MOVE;
+
+    char playerColor = (position.sideToMove == WHITE) ? 'W' : 'B';
+    MoveList moves;
+    generateAllPossibleMoves(position, playerColor, moves);
+    for (PackedMove candidate : moves) {
+        if (candidate != move) continue;
+        ply = 0;
+        makeMoveOnBoard(move);
+        bool legal = !isInCheck(position, playerColor == 'W' ? 'K' : 'k');
+        unmakeMoveOnBoard(move);
+        return legal ? move : NO_MOVE;
+    }
+    return NO_MOVE;
 }
 
 void BotPlayer::makeMove() {
@@ -23,13 +149,14 @@ void BotPlayer::makeMove() {
         // Блокируем ход игрока
         chessBoard->isPlayerTurn = false;
         chessBoard->updateMessage();
-
-        // Генерируем случайную задержку от 1 до 3 секунд
-        double delay = 1.0 + static_cast<double>(rand()) / RAND_MAX * 2.0;
-        std::cout << "Delay for bot move: " << delay << " seconds." << std::endl;
-
-        // Планируем ход бота
-        Fl::add_timeout(delay, botMoveCallback, this);
+        chessBoard->activeBot = this;
+
+        // Позицию копируем здесь, в потоке FLTK: рабочий поток не трогает ChessGame.
+        // Вместо искусственной задержки бот думает отведённое ему время.
+        copyGameState(*chessGame, position);
+        cancelRequested = false;
+        resultPosted = false;
+        worker = std::thread(&BotPlayer::searchInBackground, this);
     } else {
         std::cout << "chessBoard is nullptr. Test mode." << std::endl;
         // В режиме тестирования выполняем ход сразу
@@ -37,269 +164,786 @@ void BotPlayer::makeMove() {
     }
 }
 
+bool BotPlayer::cancel() {
+    cancelRequested = true;
+    if (worker.joinable()) worker.join();
+    chessBoard = nullptr;
+    // После join флаг окончательный: без уведомления бота больше никто не удалит
+    return !resultPosted;
+}
+
+// Рабочий поток: ищет ход и передаёт его в поток FLTK.
+// Отменённый поиск уведомление не отправляет - бота удаляет тот, кто отменил.
+void BotPlayer::searchInBackground() {
+    searchResult = search();
+    if (cancelRequested) return;
+    resultPosted = true;
+    Fl::awake(botMoveCallback, this);
+}
+
 void BotPlayer::performBotMove() {
     std::cout << "BotPlayer::performBotMove() called." << std::endl;
 
-    // Создаём копию текущего состояния игры
-    GameState currentState;
-    copyGameState(*chessGame, currentState);
-    std::cout << "GameState copied." << std::endl;
+    // Копируем текущую позицию игры; дальше перебор идёт на ней на месте
+    copyGameState(*chessGame, position);
+    applyBotMove(search());
+}
+
+// Поиск хода на уже скопированной позиции
+BotPlayer::BotMove BotPlayer::search() {
+    searchStart = std::chrono::steady_clock::now();
+    PackedMove bookMove = probeBook();
+    if (bookMove != NO_MOVE) {
+        searchPV[0] = bookMove;
+        searchPVLength = 1;
+        std::cout << "Book move " << moveName(bookMove) << " in "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - searchStart).count()
+                  << " us." << std::endl;
+        return {bookMove, 0};
+    }
 
-    // Используем алгоритм minimax для поиска лучшего хода
-    BotMove bestMove = minimax(currentState, maxDepth, -1000000, 1000000, true);
-    std::cout << "minimax completed." << std::endl;
+    transpositionTable().newSearch();
+    computeTimeBudget();
+    std::cout << "Search started. Time budget: " << hardTimeMs << " ms, threads: "
+              << searchThreads << "." << std::endl;
+
+    // Lazy SMP: вспомогательные потоки ищут ту же позицию со своими глубинами и порядком ходов
+    // и делятся результатами только через общую таблицу перестановок
+    std::atomic<bool> stopAll(false);
+    stopSignal = &stopAll;
+    threadId = 0;
+    orderingSeed = 0;
+    pawnTable = &pawnTableFor(0);
+
+    std::vector<std::unique_ptr<BotPlayer>>& pool = searchHelpers();
+    while (static_cast<int>(pool.size()) < searchThreads - 1) pool.emplace_back(new BotPlayer(nullptr));
+    std::vector<BotPlayer*> helpers;
+    std::vector<std::thread> threads;
+    for (int i = 1; i < searchThreads; ++i) {
+        helpers.push_back(pool[i - 1].get());
+        BotPlayer& helper = *helpers.back();
+        helper.position = position;
+        helper.limits = limits;
+        helper.options = options;
+        helper.searchStart = searchStart;
+        helper.softTimeMs = softTimeMs;
+        helper.hardTimeMs = hardTimeMs;
+        helper.threadId = i;
+        helper.pawnTable = &pawnTableFor(i);
+        helper.stopSignal = &stopAll;
+        helper.orderingSeed = static_cast<unsigned>(i) * 0x9E3779B9u;
+        threads.emplace_back(&BotPlayer::iterativeDeepening, &helper);
+    }
 
-    if (bestMove.move.fromRow == -1) {
+    iterativeDeepening();
+    stopAll = true;
+    for (auto& thread : threads) thread.join();
+
+    // Ход берём у потока, завершившего самую глубокую итерацию
+    BotMove bestMove = rootBest;
+    int bestDepth = completedDepth;
+    const BotPlayer* bestThread = this;
+    long long totalNodes = nodes;
+    long long totalQNodes = qnodes;
+    long long nullTries = nullMoveTries, nullCuts = nullMoveCutoffs;
+    long long reductions = lmrReductions, researches = lmrResearches;
+    long long pvsFails = pvsResearches, windowFails = aspirationFails;
+    long long pawnHits = pawnTable->hits();
+    long long pawnProbes = pawnHits + pawnTable->misses();
+    for (BotPlayer* helper : helpers) {
+        totalNodes += helper->nodes;
+        totalQNodes += helper->qnodes;
+        nullTries += helper->nullMoveTries;
+        nullCuts += helper->nullMoveCutoffs;
+        reductions += helper->lmrReductions;
+        researches += helper->lmrResearches;
+        pvsFails += helper->pvsResearches;
+        windowFails += helper->aspirationFails;
+        pawnHits += helper->pawnTable->hits();
+        pawnProbes += helper->pawnTable->hits() + helper->pawnTable->misses();
+        if (helper->completedDepth > bestDepth && helper->rootBest.move != NO_MOVE) {
+            bestMove = helper->rootBest;
+            bestDepth = helper->completedDepth;
+            bestThread = helper;
+        }
+    }
+    stopSignal = nullptr;
+    searchPVLength = bestThread->previousPVLength;
+    std::copy(bestThread->previousPV, bestThread->previousPV + searchPVLength, searchPV);
+
+    std::cout << "negamax completed: depth " << bestDepth << ", " << totalNodes << " nodes, "
+              << totalQNodes << " in quiescence (" << (totalNodes ? totalQNodes * 100 / totalNodes : 0)
+              << "%), " << totalNodes * 1000 / std::max(elapsedMs(), 1LL) << " nps, hashfull "
+              << transpositionTable().hashfull() << " permill, pawn hash hits "
+              << (pawnProbes ? pawnHits * 100 / pawnProbes : 0) << "%." << std::endl;
+    std::cout << "null move: " << nullCuts << " cutoffs of " << nullTries << " tries; LMR: "
+              << reductions << " reduced, " << researches << " re-searched; PVS re-searches: "
+              << pvsFails << ", aspiration fails: " << windowFails << "." << std::endl;
+    std::cout << "pv " << principalVariationText() << std::endl;
+
+    return bestMove;
+}
+
+void BotPlayer::applyBotMove(const BotMove& bestMove) {
+    if (bestMove.move == NO_MOVE) {
         std::cout << "No valid moves available." << std::endl;
         // Нет доступных ходов, игра окончена
         return;
     }
 
-    std::cout << "Best move found: from (" << bestMove.move.fromRow << ", " << bestMove.move.fromCol
-              << ") to (" << bestMove.move.toRow << ", " << bestMove.move.toCol << ")." << std::endl;
+    int from = moveFrom(bestMove.move);
+    int to = moveTo(bestMove.move);
+    std::cout << "Best move found: from (" << squareRow(from) << ", " << squareCol(from)
+              << ") to (" << squareRow(to) << ", " << squareCol(to) << ")." << std::endl;
 
-    // Выполняем лучший ход на реальной доске
-    chessGame->movePiece(bestMove.move.fromRow, bestMove.move.fromCol, bestMove.move.toRow, bestMove.move.toCol);
+    // Выполняем лучший ход на реальной доске; movePiece сам записывает его в историю
+    chessGame->movePiece(squareRow(from), squareCol(from), squareRow(to), squareCol(to));
     std::cout << "Move executed on the game board." << std::endl;
+}
 
-    // Добавляем ход в историю
-    chessGame->moveHistory.push_back({chessGame->board[bestMove.move.toRow][bestMove.move.toCol],
-                                      bestMove.move.fromRow, bestMove.move.fromCol,
-                                      bestMove.move.toRow, bestMove.move.toCol, 'B'});
-    std::cout << "Move added to moveHistory." << std::endl;
+std::vector<PackedMove> BotPlayer::principalVariation() const {
+    return std::vector<PackedMove>(searchPV, searchPV + searchPVLength);
 }
 
-void BotPlayer::botMoveCallback(void* data) {
-    BotPlayer* bot = static_cast<BotPlayer*>(data);
+std::string BotPlayer::principalVariationText() const {
+    return formatPV(searchPV, searchPVLength);
+}
 
-    // Проверяем, существует ли chessBoard
-    if (bot->chessBoard && bot->chessBoard->gameOver) {
-        delete bot;
-        return;
+long long BotPlayer::perft(int depth, bool divide) {
+    position = chessGame->position;
+    ply = 0;
+    if (depth <= 0) return 1;
+
+    char playerColor = (position.sideToMove == WHITE) ? 'W' : 'B';
+    MoveList moves;
+    generateAllPossibleMoves(position, playerColor, moves);
+
+    long long total = 0;
+    for (PackedMove move : moves) {
+        makeMoveOnBoard(move);
+        if (!isInCheck(position, playerColor == 'W' ? 'K' : 'k')) {
+            long long count = perftNode(depth - 1);
+            total += count;
+            if (divide) std::cout << moveName(move) << ": " << count << std::endl;
+        }
+        unmakeMoveOnBoard(move);
     }
+    return total;
+}
 
-    // Выполняем ход бота
-    bot->performBotMove();
+long long BotPlayer::perftNode(int depth) {
+    if (depth == 0) return 1;
 
-    // Если chessBoard существует, обновляем GUI
-    if (bot->chessBoard) {
-        // Обновляем доску после хода бота
-        Fl::redraw();
+    char playerColor = (position.sideToMove == WHITE) ? 'W' : 'B';
+    MoveList moves;
+    generateAllPossibleMoves(position, playerColor, moves);
 
-        // Проверяем, находится ли белый король под шахом
-        if (bot->chessGame->isInCheck('K')) {
-            if (bot->chessGame->isInCheckmate('K')) {
-                bot->chessBoard->gameOver = true;
-                fl_message("Чёрные победили! Мат белому королю.");
-                bot->chessBoard->updateMessage();
-                bot->chessBoard->showCheckWindow(false); // Скрываем окно шаха
-                delete bot;
-                return;
+    long long total = 0;
+    for (PackedMove move : moves) {
+        makeMoveOnBoard(move);
+        if (!isInCheck(position, playerColor == 'W' ? 'K' : 'k')) total += perftNode(depth - 1);
+        unmakeMoveOnBoard(move);
+    }
+    return total;
+}
+
+// Итеративное углубление одного потока: каждая итерация начинается с главного варианта
+// предыдущей. Результат берётся только из полностью завершённых итераций.
+void BotPlayer::iterativeDeepening() {
+    ply = 0;
+    nodes = 0;
+    qnodes = 0;
+    nullMoveTries = nullMoveCutoffs = 0;
+    lmrReductions = lmrResearches = 0;
+    pvsResearches = aspirationFails = 0;
+    pawnTable->resetStats();
+    stopped = false;
+    previousPVLength = 0;
+    completedDepth = 0;
+    rootBest.move = NO_MOVE;
+    rootBest.score = 0;
+    clearMoveOrdering();
+
+    for (rootDepth = 1; rootDepth <= limits.maxDepth && rootDepth < MAX_PLY; ++rootDepth) {
+        if (skipDepth(rootDepth)) continue;
+
+        // Окно стремления: ищем в узком окне вокруг оценки прошлой итерации и расширяем
+        // его в сторону неудачи, пока оценка не окажется внутри
+        int delta = ASPIRATION_WINDOW;
+        int alpha = -INFINITE_SCORE;
+        int beta = INFINITE_SCORE;
+        if (rootDepth >= ASPIRATION_MIN_DEPTH && completedDepth > 0) {
+            alpha = rootBest.score - delta;
+            beta = rootBest.score + delta;
+        }
+        BotMove result;
+        while (true) {
+            followPV = true;
+            result.score = negamax<NODE_ROOT>(rootDepth, alpha, beta);
+            result.move = rootMove;
+            if (stopped) break;
+            if (result.score <= alpha && alpha > -INFINITE_SCORE) {
+                ++aspirationFails;
+                alpha = (delta < ASPIRATION_FULL_WIDTH) ? std::max(result.score - delta, -INFINITE_SCORE) : -INFINITE_SCORE;
+            } else if (result.score >= beta && beta < INFINITE_SCORE) {
+                ++aspirationFails;
+                beta = (delta < ASPIRATION_FULL_WIDTH) ? std::min(result.score + delta, INFINITE_SCORE) : INFINITE_SCORE;
             } else {
-                bot->chessBoard->showCheckWindow(true); // Показываем окно шаха
+                break;
             }
-        } else {
-            bot->chessBoard->showCheckWindow(false); // Скрываем окно шаха
+            delta *= 2;
         }
+        if (stopped) break;
+        // Итерация без хода (в корне нет допустимых ходов) не затирает ход прошлой итерации
+        if (result.move == NO_MOVE) break;
 
-        // Разблокируем ход игрока
-        bot->chessBoard->isPlayerTurn = true;
-        bot->chessBoard->currentPlayer = 'W';
-        bot->chessBoard->updateMessage();
+        rootBest = result;
+        completedDepth = rootDepth;
+        previousPVLength = pvLength[0];
+        std::copy(pvTable[0], pvTable[0] + pvLength[0], previousPV);
 
-        // Удаляем объект бота
-        delete bot;
+        if (threadId != 0) continue;
+
+        std::cout << "depth " << rootDepth << " score " << result.score << " nodes " << nodes
+                  << " qnodes " << qnodes << " time " << elapsedMs() << " ms pv "
+                  << formatPV(previousPV, previousPVLength) << std::endl;
+
+        if (elapsedMs() >= softTimeMs) break;    // Следующая итерация не успеет завершиться
     }
 }
 
-// Рекурсивная функция minimax с альфа-бета отсечением
-BotPlayer::BotMove BotPlayer::minimax(const GameState& state, int depth, int alpha, int beta, bool isMaximizingPlayer) {
-    if (depth == 0 || isGameOver(state)) {
-        int score = evaluateBoard(state);
-        return {{-1, -1, -1, -1, ' '}, score};
+// Вспомогательные потоки пропускают часть глубин по разным схемам, чтобы одновременно
+// считались разные итерации (таблицы размеров и фаз циклов как в Stockfish)
+bool BotPlayer::skipDepth(int depth) const {
+    static const int skipSize[20] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+    static const int skipPhase[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+    if (threadId == 0 || depth == 1) return false;
+    int i = (threadId - 1) % 20;
+    return ((depth + skipPhase[i]) / skipSize[i]) % 2 != 0;
+}
+
+void BotPlayer::clearMoveOrdering() {
+    for (int i = 0; i < MAX_PLY; ++i) {
+        killers[i][0] = killers[i][1] = NO_MOVE;
     }
+    for (int c = 0; c < 2; ++c)
+        for (int f = 0; f < 64; ++f)
+            for (int t = 0; t < 64; ++t)
+                history[c][f][t] = 0;
+}
 
-    char playerColor = isMaximizingPlayer ? 'B' : 'W';
-    std::vector<Move> possibleMoves = generateAllPossibleMoves(state, playerColor);
+// Распределение времени: фиксированное время на ход либо доля оставшихся часов
+void BotPlayer::computeTimeBudget() {
+    if (limits.moveTimeMs > 0) {
+        hardTimeMs = limits.moveTimeMs;
+    } else if (limits.clockMs > 0) {
+        hardTimeMs = limits.clockMs / 30 + limits.incrementMs * 3 / 4;
+        hardTimeMs = std::min<long long>(hardTimeMs, std::max(limits.clockMs - 50, 1));
+    } else {
+        hardTimeMs = 1LL << 40;  // Ограничение только по глубине
+    }
+    // Итерация обычно стоит в несколько раз больше предыдущей: не начинаем новую после половины
+    softTimeMs = hardTimeMs / 2;
+}
 
-    if (possibleMoves.empty()) {
-        // Нет доступных ходов
-        int score = evaluateBoard(state);
-        return {{-1, -1, -1, -1, ' '}, score};
+long long BotPlayer::elapsedMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - searchStart).count();
+}
+
+// Проверка времени и отмены раз в 2048 узлов. Первая итерация основного потока по времени не прерывается.
+void BotPlayer::checkTime() {
+    if ((nodes & 2047) != 0) return;
+    if (threadId != 0) {
+        // Вспомогательные потоки останавливает только основной
+        if (stopSignal->load(std::memory_order_relaxed)) stopped = true;
+    } else if (cancelRequested.load(std::memory_order_relaxed)) {
+        stopped = true;
+    } else if (rootDepth > 1 && elapsedMs() >= hardTimeMs) {
+        stopped = true;
     }
+}
 
-    BotMove bestMove;
-    if (isMaximizingPlayer) {
-        bestMove.score = -1000000;
-        for (const auto& move : possibleMoves) {
-            // Создаём копию состояния игры для следующего хода
-            GameState newState = state;
+void BotPlayer::botMoveCallback(void* data) {
+    BotPlayer* bot = static_cast<BotPlayer*>(data);
+    if (bot->worker.joinable()) bot->worker.join();
 
-            // Выполняем ход на новой копии состояния
-            makeMoveOnBoard(newState, move);
+    // Доска закрыта, пока бот думал: ход уже никому не нужен
+    if (!bot->chessBoard) {
+        delete bot;
+        return;
+    }
+    bot->chessBoard->activeBot = nullptr;
 
-            // Проверяем, не оставили ли мы своего короля под шахом
-            if (isInCheck(newState, 'k')) {
-                // Недопустимый ход, пропускаем его
-                continue;
-            }
+    if (bot->chessBoard->gameOver || bot->cancelRequested) {
+        delete bot;
+        return;
+    }
 
-            // Рекурсивный вызов
-            BotMove currentMove = minimax(newState, depth - 1, alpha, beta, false);
+    // Бот играет той стороной, чей ход был в позиции поиска
+    char botColor = (bot->position.sideToMove == WHITE) ? 'W' : 'B';
+    char opponentKing = (botColor == 'W') ? 'k' : 'K';
+
+    // Хода нет только у стороны без допустимых ходов: партия окончена, ход игроку не отдаём
+    if (bot->searchResult.move == NO_MOVE) {
+        bot->chessBoard->gameOver = true;
+        if (bot->chessGame->isInCheck(botColor == 'W' ? 'K' : 'k')) {
+            fl_message("%s победили! Мат %s королю.",
+                       botColor == 'W' ? "Чёрные" : "Белые",
+                       botColor == 'W' ? "белому" : "чёрному");
+        } else {
+            fl_message("Пат. Ничья.");
+        }
+        bot->chessBoard->updateMessage();
+        bot->chessBoard->showCheckWindow(false);
+        delete bot;
+        return;
+    }
 
-            if (currentMove.score > bestMove.score) {
-                bestMove.move = move;
-                bestMove.score = currentMove.score;
-            }
-            alpha = std::max(alpha, bestMove.score);
-            if (beta <= alpha) {
-                break; // Beta отсечение
-            }
+    // Выполняем найденный ход
+    bot->applyBotMove(bot->searchResult);
+
+    // Обновляем доску после хода бота
+    Fl::redraw();
+
+    // Проверяем, находится ли король соперника под шахом
+    if (bot->chessGame->isInCheck(opponentKing)) {
+        if (bot->chessGame->isInCheckmate(opponentKing)) {
+            bot->chessBoard->gameOver = true;
+            fl_message("%s победили! Мат %s королю.",
+                       botColor == 'W' ? "Белые" : "Чёрные",
+                       botColor == 'W' ? "чёрному" : "белому");
+            bot->chessBoard->updateMessage();
+            bot->chessBoard->showCheckWindow(false); // Скрываем окно шаха
+            delete bot;
+            return;
+        } else {
+            bot->chessBoard->showCheckWindow(true); // Показываем окно шаха
         }
     } else {
-        bestMove.score = 1000000;
-        for (const auto& move : possibleMoves) {
-            // Создаём копию состояния игры для следующего хода
-            GameState newState = state;
+        bot->chessBoard->showCheckWindow(false); // Скрываем окно шаха
+        if (bot->chessGame->isStalemate(opponentKing)) {
+            bot->chessBoard->gameOver = true;
+            fl_message("Пат. Ничья.");
+            bot->chessBoard->updateMessage();
+            delete bot;
+            return;
+        }
+    }
 
-            // Выполняем ход на новой копии состояния
-            makeMoveOnBoard(newState, move);
+    // Разблокируем ход игрока
+    bot->chessBoard->isPlayerTurn = true;
+    bot->chessBoard->currentPlayer = (botColor == 'W') ? 'B' : 'W';
+    bot->chessBoard->updateMessage();
 
-            // Проверяем, не оставили ли мы своего короля под шахом
-            if (isInCheck(newState, 'K')) {
-                // Недопустимый ход, пропускаем его
-                continue;
-            }
+    // Удаляем объект бота
+    delete bot;
+}
 
-            // Рекурсивный вызов
-            BotMove currentMove = minimax(newState, depth - 1, alpha, beta, true);
+// Рекурсивный поиск negamax с альфа-бета отсечением. Оценки даются со стороны, чей ход,
+// поэтому один и тот же код ищет за любой цвет. Тип узла известен при компиляции:
+// в узлах с нулевым окном нет перепроверок PVS и главного варианта, в узлах главного варианта -
+// отсечений по таблице и нулевым ходом.
+// Ходы делаются и отменяются на одной позиции, без копирования состояния в каждом узле.
+template <BotPlayer::NodeType nodeType>
+int BotPlayer::negamax(int depth, int alpha, int beta) {
+    constexpr bool rootNode = nodeType == NODE_ROOT;
+    constexpr bool pvNode = nodeType != NODE_NON_PV;
+
+    // На листьях досчитываем размены, чтобы не оценивать позицию посреди них
+    if (depth <= 0 && !isGameOver(position)) {
+        return quiescence(alpha, beta, 0);
+    }
 
-            if (currentMove.score < bestMove.score) {
-                bestMove.move = move;
-                bestMove.score = currentMove.score;
+    ++nodes;
+    checkTime();
+    if (stopped) {
+        return 0;
+    }
+
+    pvLength[ply] = 0;
+    if (depth <= 0 || isGameOver(position) || ply >= MAX_PLY) {
+        return evaluateBoard(position);
+    }
+
+    // Проверяем таблицу перестановок. На главном варианте не отсекаем: там нужны сами ходы.
+    TranspositionTable& table = transpositionTable();
+    uint64_t key = position.key;
+    TTData ttData;
+    PackedMove ttMove = NO_MOVE;
+    if (table.probe(key, ttData)) {
+        ttMove = ttData.move;
+        ttData.score = scoreFromTT(ttData.score, ply);
+        if (!pvNode && ttData.depth >= depth) {
+            if (ttData.bound == BOUND_EXACT) {
+                return ttData.score;
             }
-            beta = std::min(beta, bestMove.score);
-            if (beta <= alpha) {
-                break; // Alpha отсечение
+            if (ttData.bound == BOUND_LOWER) alpha = std::max(alpha, ttData.score);
+            if (ttData.bound == BOUND_UPPER) beta = std::min(beta, ttData.score);
+            if (alpha >= beta) {
+                return ttData.score;
+            }
+        }
+    }
+    int alphaOrig = alpha;
+
+    int us = position.sideToMove;
+    char ownKing = (us == WHITE) ? 'K' : 'k';
+    char enemyKing = (us == WHITE) ? 'k' : 'K';
+    bool inCheck = isInCheck(position, ownKing);
+
+    // Отсечение нулевым ходом: если даже после пропуска хода соперник не может опустить
+    // оценку ниже beta, узел отсекается без перебора. Не делается под шахом,
+    // на главном варианте, два раза подряд и без фигур, где пропуск хода бывает выгоднее любого хода (цугцванг).
+    if (!pvNode && options.nullMove && depth >= options.nullMoveMinDepth && !inCheck &&
+        undoStack[ply - 1].movedPiece != '.' &&
+        (position.byColor[us] & ~(position.piecesOf(us, PAWN) | position.piecesOf(us, KING)))) {
+        if (evaluateBoard(position) >= beta) {
+            ++nullMoveTries;
+            int nullDepth = depth - 1 - options.nullMoveReduction - depth / 6;
+            position.makeNullMove(undoStack[ply]);
+            ++ply;
+            int score = -negamax<NODE_NON_PV>(nullDepth, -beta, -beta + 1);
+            --ply;
+            position.unmakeNullMove(undoStack[ply]);
+            if (stopped) return 0;
+            if (score >= beta) {
+                ++nullMoveCutoffs;
+                // Мат после пропуска хода не доказан ходом из позиции: не возвращаем его как мат
+                return (score >= MATE_BOUND) ? beta : score;
             }
         }
     }
-    return bestMove;
-}
 
-// Функция для выполнения хода на виртуальной доске
-void BotPlayer::makeMoveOnBoard(GameState& state, const Move& move) {
-    char piece = state.board[move.fromRow][move.fromCol];
-    char targetPiece = state.board[move.toRow][move.toCol];
+    MoveList possibleMoves;
+    generateAllPossibleMoves(position, us == WHITE ? 'W' : 'B', possibleMoves);
+
+    // Пока идём по главному варианту прошлой итерации, его ход важнее хода из таблицы
+    PackedMove pvMove = NO_MOVE;
+    if (followPV && ply < previousPVLength) pvMove = previousPV[ply];
+    followPV = false;
+
+    int moveScores[MAX_MOVES];
+    scoreMoves(possibleMoves, moveScores, ttMove, pvMove);
+
+    // Ниже любой достижимой оценки: первый же допустимый ход станет лучшим, даже если он ведёт к мату
+    int bestScore = -INFINITE_SCORE;
+    PackedMove bestMove = NO_MOVE;
+    int movesSearched = 0;
+    for (int i = 0; i < possibleMoves.size(); ++i) {
+        // Ленивая сортировка выбором: следующий по оценке ход ставится на место i
+        pickNextMove(possibleMoves, moveScores, i);
+        PackedMove move = possibleMoves[i];
+        bool isQuiet = !isCaptureMove(move) && !isPromotionMove(move);
+
+        // Выполняем ход на позиции
+        followPV = moveScores[i] == PV_MOVE_SCORE;
+        makeMoveOnBoard(move);
+
+        // Проверяем, не оставили ли мы своего короля под шахом
+        if (isInCheck(position, ownKing)) {
+            // Недопустимый ход, пропускаем его
+            unmakeMoveOnBoard(move);
+            continue;
+        }
+        ++movesSearched;
+
+        // Поздние тихие ходы (не убийцы, без шаха) сначала ищем с сокращённой глубиной и нулевым окном
+        int reduction = 0;
+        if (options.lateMoveReductions && isQuiet && depth >= options.lmrMinDepth &&
+            movesSearched > options.lmrMinMoves && !inCheck && moveScores[i] < KILLER_SCORE_2 &&
+            !isInCheck(position, enemyKing)) {
+            reduction = (movesSearched > 2 * options.lmrMinMoves && depth >= 6) ? 2 : 1;
+        }
 
-    // Если на целевой клетке есть фигура противника, добавляем её в список захваченных
-    if (targetPiece != '.') {
-        if (targetPiece >= 'A' && targetPiece <= 'Z') {
-            state.whiteCapturedPieces.push_back(targetPiece);
+        // Рекурсивный вызов. Первый ход ищем с полным окном, остальные (PVS) - с нулевым:
+        // он лишь доказывает, что ход не лучше найденного. Если доказать не удалось - перепроверяем.
+        int score;
+        if (movesSearched == 1) {
+            score = -negamax<pvNode ? NODE_PV : NODE_NON_PV>(depth - 1, -beta, -alpha);
         } else {
-            state.blackCapturedPieces.push_back(targetPiece);
+            if (reduction > 0) ++lmrReductions;
+            score = -negamax<NODE_NON_PV>(depth - 1 - reduction, -alpha - 1, -alpha);
+            // Сокращённый поиск показал, что ход может быть лучше: проверяем на полной глубине
+            if (!stopped && reduction > 0 && score > alpha) {
+                ++lmrResearches;
+                score = -negamax<NODE_NON_PV>(depth - 1, -alpha - 1, -alpha);
+            }
+            if (pvNode && !stopped && score > alpha && score < beta) {
+                ++pvsResearches;
+                score = -negamax<NODE_PV>(depth - 1, -beta, -alpha);
+            }
         }
-    }
-
-    // Перемещаем фигуру
-    state.board[move.toRow][move.toCol] = piece;
-    state.board[move.fromRow][move.fromCol] = '.';
+        unmakeMoveOnBoard(move);
+        if (stopped) return bestScore;
 
-    // Обработка превращения пешки
-    if (tolower(piece) == 'p') {
-        if (piece == 'P' && move.toRow == 0) {
-            state.board[move.toRow][move.toCol] = 'Q'; // Белая пешка превращается в ферзя
-        } else if (piece == 'p' && move.toRow == 7) {
-            state.board[move.toRow][move.toCol] = 'q'; // Чёрная пешка превращается в ферзя
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+            if (pvNode) updatePV(move);
+        }
+        alpha = std::max(alpha, bestScore);
+        if (alpha >= beta) {
+            if (isQuiet) updateQuietStats(move, depth);
+            break; // Beta отсечение
         }
     }
-}
 
-// Функция оценки состояния доски
-int BotPlayer::evaluateBoard(const GameState& state) {
-    int score = 0;
-
-    int pieceValues[256] = {0};
-    pieceValues['P'] = -100;
-    pieceValues['N'] = -320;
-    pieceValues['B'] = -330;
-    pieceValues['R'] = -500;
-    pieceValues['Q'] = -900;
-    pieceValues['K'] = -20000;
-    pieceValues['p'] = 100;
-    pieceValues['n'] = 320;
-    pieceValues['b'] = 330;
-    pieceValues['r'] = 500;
-    pieceValues['q'] = 900;
-    pieceValues['k'] = 20000;
-
-    for (int i = 0; i < SIZE; ++i) {
-        for (int j = 0; j < SIZE; ++j) {
-            char piece = state.board[i][j];
-            if (piece != '.') {
-                score += pieceValues[static_cast<unsigned char>(piece)];
-            }
-        }
+    // Допустимых ходов нет: мат или пат
+    if (movesSearched == 0) {
+        bestScore = inCheck ? -MATE_SCORE + ply : 0;
     }
+    if (rootNode) rootMove = bestMove;
 
-    // Добавляем оценку за тактические мотивы
-    score += evaluateTactics(state, 'B'); // Положительный счёт для тактик бота
-    score -= evaluateTactics(state, 'W'); // Отрицательный счёт для тактик соперника
+    // Сохраняем результат: тип оценки определяется положением относительно исходного окна
+    int bound = (bestScore <= alphaOrig) ? BOUND_UPPER
+              : (bestScore >= beta) ? BOUND_LOWER
+              : BOUND_EXACT;
+    table.store(key, depth, bound, scoreToTT(bestScore, ply), bestMove);
 
+    return bestScore;
+}
+
+int BotPlayer::scoreToTT(int score, int ply) {
+    if (score >= MATE_BOUND) return score + ply;
+    if (score <= -MATE_BOUND) return score - ply;
     return score;
 }
 
-// Функция оценки тактических мотивов
-int BotPlayer::evaluateTactics(const GameState& state, char playerColor) {
-    int score = 0;
+int BotPlayer::scoreFromTT(int score, int ply) {
+    if (score >= MATE_BOUND) return score - ply;
+    if (score <= -MATE_BOUND) return score + ply;
+    return score;
+}
 
-    // Цвет соперника
-    char opponentColor = (playerColor == 'W') ? 'B' : 'W';
+// Поиск взятий и превращений на листьях. Сторона может не брать и остаться
+// при статической оценке (stand pat); оценки, как и в negamax, со стороны, чей ход.
+// Под шахом stand pat нет: перебираются все ответы на шах, без них - мат.
+int BotPlayer::quiescence(int alpha, int beta, int qdepth) {
+    ++nodes;
+    ++qnodes;
+    checkTime();
+    if (stopped) return 0;
+
+    pvLength[ply] = 0;
+    int standPat = evaluateBoard(position);
+    if (qdepth >= MAX_QSEARCH_DEPTH || ply >= MAX_PLY - 1) return standPat;
+
+    int us = position.sideToMove;
+    char ownKing = (us == WHITE) ? 'K' : 'k';
+    bool inCheck = isInCheck(position, ownKing);
+
+    int bestScore = -INFINITE_SCORE;
+    if (!inCheck) {
+        if (standPat >= beta) return standPat;
+        alpha = std::max(alpha, standPat);
+        bestScore = standPat;
+    }
 
-    // Пример тактической оценки: контроль центра
-    for (int i = 2; i <= 5; ++i) {
-        for (int j = 2; j <= 5; ++j) {
-            char piece = state.board[i][j];
-            if (piece != '.') {
-                if ((playerColor == 'W' && piece >= 'A' && piece <= 'Z') ||
-                    (playerColor == 'B' && piece >= 'a' && piece <= 'z')) {
-                    score += 10; // Увеличиваем счёт за контроль центра
-                }
+    MoveList moves;
+    if (inCheck) {
+        generateAllPossibleMoves(position, us == WHITE ? 'W' : 'B', moves);
+    } else {
+        generateCaptures(position, us == WHITE ? 'W' : 'B', moves);
+    }
+    int moveScores[MAX_MOVES];
+    scoreMoves(moves, moveScores, NO_MOVE, NO_MOVE);
+
+    bool hasLegalMove = false;
+    for (int i = 0; i < moves.size(); ++i) {
+        pickNextMove(moves, moveScores, i);
+        PackedMove move = moves[i];
+        // Ходы отсортированы: дальше только взятия, проигрывающие размен
+        if (!inCheck && moveScores[i] < CAPTURE_SCORE) break;
+
+        // Дельта-отсечение: даже выигрыш взятой фигуры с запасом не поднимает оценку до alpha
+        if (!inCheck && !isPromotionMove(move)) {
+            char victim = position.pieceAt(moveTo(move));
+            int gain = (victim == '.') ? materialValue('p') : materialValue(victim);
+            if (standPat + gain + DELTA_MARGIN <= alpha) {
+                continue;
             }
         }
+
+        makeMoveOnBoard(move);
+        if (isInCheck(position, ownKing)) {
+            unmakeMoveOnBoard(move);
+            continue;
+        }
+        hasLegalMove = true;
+        int score = -quiescence(-beta, -alpha, qdepth + 1);
+        unmakeMoveOnBoard(move);
+        if (stopped) return 0;
+
+        bestScore = std::max(bestScore, score);
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) break;
     }
 
-    return score;
+    // Под шахом и без ходов: мат, расстояние от корня - как в negamax
+    if (inCheck && !hasLegalMove) return -MATE_SCORE + ply;
+    return bestScore;
 }
 
-// Функция генерации всех возможных ходов для игрока
-std::vector<Move> BotPlayer::generateAllPossibleMoves(const GameState& state, char playerColor) {
-    std::vector<Move> possibleMoves;
+// Взятие, в том числе на проходе
+bool BotPlayer::isCaptureMove(PackedMove move) const {
+    return position.pieceAt(moveTo(move)) != '.' || moveKind(move) == MOVE_EN_PASSANT;
+}
+
+// Оценки для упорядочивания: ход главного варианта, ход из таблицы, взятия по MVV-LVA,
+// ходы-убийцы, тихие ходы по таблице истории, затем взятия, проигрывающие размен (SEE)
+void BotPlayer::scoreMoves(const MoveList& moves, int scores[], PackedMove ttMove, PackedMove pvMove) {
+    int us = position.sideToMove;
+    for (int i = 0; i < moves.size(); ++i) {
+        PackedMove move = moves[i];
+        int from = moveFrom(move);
+        int to = moveTo(move);
+
+        if (pvMove != NO_MOVE && move == pvMove) {
+            scores[i] = PV_MOVE_SCORE;
+        } else if (ttMove != NO_MOVE && move == ttMove) {
+            scores[i] = TT_MOVE_SCORE;
+        } else if (isCaptureMove(move)) {
+            // Самая ценная жертва, самый дешёвый нападающий. Размен считаем, только если
+            // нападающий дороже жертвы: иначе взятие заведомо не проигрывает.
+            char victim = position.pieceAt(to);
+            int victimValue = (victim == '.') ? orderValue('p') : orderValue(victim);
+            int attackerValue = orderValue(position.pieceAt(from));
+            bool losing = attackerValue > victimValue && !isPromotionMove(move) && position.see(from, to) < 0;
+            scores[i] = (losing ? LOSING_CAPTURE_SCORE : CAPTURE_SCORE) + victimValue * 100 - attackerValue;
+        } else if (isPromotionMove(move)) {
+            scores[i] = CAPTURE_SCORE + orderValue('q') * 100 - orderValue('p');
+        } else if (move == killers[ply][0]) {
+            scores[i] = KILLER_SCORE_1;
+        } else if (move == killers[ply][1]) {
+            scores[i] = KILLER_SCORE_2;
+        } else {
+            scores[i] = history[us][from][to];
+            if (orderingSeed) scores[i] += ((static_cast<unsigned>(from << 6 | to) * 0x9E3779B1u) ^ orderingSeed) >> 28;
+        }
+    }
+}
+
+// Находит среди ходов с индекса index лучший по оценке и ставит его на место index
+void BotPlayer::pickNextMove(MoveList& moves, int scores[], int index) {
+    int best = index;
+    for (int i = index + 1; i < moves.size(); ++i) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    if (best != index) {
+        std::swap(moves[index], moves[best]);
+        std::swap(scores[index], scores[best]);
+    }
+}
+
+// Тихий ход вызвал отсечение: запоминаем его как убийцу и поднимаем в истории
+void BotPlayer::updateQuietStats(PackedMove move, int depth) {
+    if (move != killers[ply][0]) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+
+    int us = position.sideToMove;
+    int& entry = history[us][moveFrom(move)][moveTo(move)];
+    entry += depth * depth;
+    if (entry > HISTORY_MAX) {
+        // Старим всю таблицу, чтобы значения не доросли до оценок убийц
+        for (int c = 0; c < 2; ++c)
+            for (int f = 0; f < 64; ++f)
+                for (int t = 0; t < 64; ++t)
+                    history[c][f][t] /= 2;
+    }
+}
+
+// Новый лучший ход узла: главный вариант = этот ход + главный вариант потомка
+void BotPlayer::updatePV(PackedMove move) {
+    pvTable[ply][0] = move;
+    int childLength = (ply + 1 < MAX_PLY) ? pvLength[ply + 1] : 0;
+    for (int i = 0; i < childLength; ++i) {
+        pvTable[ply][i + 1] = pvTable[ply + 1][i];
+    }
+    pvLength[ply] = childLength + 1;
+}
 
-    for (int fromRow = 0; fromRow < SIZE; ++fromRow) {
-        for (int fromCol = 0; fromCol < SIZE; ++fromCol) {
-            char piece = state.board[fromRow][fromCol];
-            if (piece == '.') continue;
+// Выполнение хода на позиции перебора; данные для отмены кладутся в стек
+void BotPlayer::makeMoveOnBoard(PackedMove move) {
+    position.makeMove(move, undoStack[ply]);
+    ++ply;
+}
+
+// Отмена последнего хода, сделанного makeMoveOnBoard
+void BotPlayer::unmakeMoveOnBoard(PackedMove move) {
+    --ply;
+    position.unmakeMove(move, undoStack[ply]);
+}
 
-            // Проверяем, принадлежит ли фигура текущему игроку
-            if ((playerColor == 'W' && piece >= 'A' && piece <= 'Z') ||
-                (playerColor == 'B' && piece >= 'a' && piece <= 'z')) {
+// Функция оценки состояния доски. Материал и таблицы фигура-клетка ведёт сама позиция
+// при каждом ходе, пешечная структура берётся из пешечной таблицы. Оценка дана со стороны, чей ход.
+int BotPlayer::evaluateBoard(const Position& pos) {
+    const PawnEntry& pawns = pawnTable->probe(pos);
+    int score = pos.evaluate() + pos.taper(pawns.mg, pawns.eg);
+    return (pos.sideToMove == WHITE) ? score : -score;
+}
 
-                // Получаем все возможные ходы для данной фигуры
-                std::vector<Move> pieceMoves = getValidMovesForPiece(state, fromRow, fromCol, playerColor);
-                possibleMoves.insert(possibleMoves.end(), pieceMoves.begin(), pieceMoves.end());
+// Функция генерации всех возможных ходов для игрока
+void BotPlayer::generateAllPossibleMoves(const Position& pos, char playerColor, MoveList& moves) {
+    moves.clear();
+
+    // Перебираем только свои фигуры по битовой доске цвета
+    Bitboard own = pos.byColor[playerColor == 'W' ? WHITE : BLACK];
+    while (own) {
+        int fromSquare = popLsb(own);
+        getValidMovesForPiece(pos, squareRow(fromSquare), squareCol(fromSquare), playerColor, moves);
+    }
+}
+
+// Только взятия (в том числе на проходе) и превращения пешек - для поиска взятий
+void BotPlayer::generateCaptures(const Position& pos, char playerColor, MoveList& moves) {
+    moves.clear();
+
+    int us = (playerColor == 'W') ? WHITE : BLACK;
+    Bitboard enemies = pos.byColor[us ^ 1];
+    Bitboard own = pos.byColor[us];
+    while (own) {
+        int fromSquare = popLsb(own);
+        char piece = pos.pieceAt(fromSquare);
+        int fromRow = squareRow(fromSquare);
+        int fromCol = squareCol(fromSquare);
+
+        Bitboard targets;
+        switch (tolower(piece)) {
+            case 'p': {
+                Bitboard captureTargets = enemies;
+                if (pos.epSquare != -1) captureTargets |= squareBB(pos.epSquare);
+                targets = pawnAttacks(fromSquare, us == WHITE) & captureTargets;
+                // Тихое превращение тоже меняет материал
+                int promotionRow = (us == WHITE) ? 0 : 7;
+                int toRow = fromRow + ((us == WHITE) ? -1 : 1);
+                if (toRow == promotionRow && pos.pieceAt(makeSquare(toRow, fromCol)) == '.') {
+                    targets |= squareBB(makeSquare(toRow, fromCol));
+                }
+                break;
             }
+            case 'n': targets = knightAttacks(fromSquare) & enemies; break;
+            case 'b': targets = bishopAttacks(fromSquare, pos.occupied) & enemies; break;
+            case 'r': targets = rookAttacks(fromSquare, pos.occupied) & enemies; break;
+            case 'q': targets = queenAttacks(fromSquare, pos.occupied) & enemies; break;
+            default:  targets = kingAttacks(fromSquare) & enemies; break;
         }
-    }
 
-    return possibleMoves;
+        while (targets) {
+            moves.add(pos.encodeMove(fromSquare, popLsb(targets)));
+        }
+    }
 }
 
 // Функция получения всех допустимых ходов для конкретной фигуры
-std::vector<Move> BotPlayer::getValidMovesForPiece(const GameState& state, int fromRow, int fromCol, char playerColor) {
-    std::vector<Move> validMoves;
-
-    char piece = state.board[fromRow][fromCol];
+void BotPlayer::getValidMovesForPiece(const Position& pos, int fromRow, int fromCol, char playerColor, MoveList& moves) {
+    int fromSquare = makeSquare(fromRow, fromCol);
+    char piece = pos.pieceAt(fromSquare);
+    int us = (playerColor == 'W') ? WHITE : BLACK;
+    Bitboard ownPieces = pos.byColor[us];
 
     if (tolower(piece) == 'p') {
         // Логика для пешки
@@ -309,213 +953,92 @@ std::vector<Move> BotPlayer::getValidMovesForPiece(const GameState& state, int f
         // Ход вперёд
         int toRow = fromRow + direction;
         if (toRow >= 0 && toRow < SIZE) {
-            if (state.board[toRow][fromCol] == '.') {
-                validMoves.push_back({piece, fromRow, fromCol, toRow, fromCol, playerColor});
+            int kind = (toRow == 0 || toRow == SIZE - 1) ? MOVE_PROMOTION : MOVE_NORMAL;
+            if (pos.pieceAt(makeSquare(toRow, fromCol)) == '.') {
+                moves.add(packMove(fromSquare, makeSquare(toRow, fromCol), kind));
                 // Первый ход пешки на два поля
                 if (fromRow == startRow) {
                     int toRow2 = toRow + direction;
-                    if (toRow2 >= 0 && toRow2 < SIZE && state.board[toRow2][fromCol] == '.') {
-                        validMoves.push_back({piece, fromRow, fromCol, toRow2, fromCol, playerColor});
+                    if (toRow2 >= 0 && toRow2 < SIZE && pos.pieceAt(makeSquare(toRow2, fromCol)) == '.') {
+                        moves.add(packMove(fromSquare, makeSquare(toRow2, fromCol)));
                     }
                 }
             }
-            // Взятие фигур
-            for (int dc = -1; dc <= 1; dc += 2) {
-                int toCol = fromCol + dc;
-                if (toCol >= 0 && toCol < SIZE) {
-                    char targetPiece = state.board[toRow][toCol];
-                    if (targetPiece != '.' && isOpponentPiece(piece, targetPiece)) {
-                        validMoves.push_back({piece, fromRow, fromCol, toRow, toCol, playerColor});
-                    }
-                }
+            // Взятие фигур, в том числе на проходе
+            Bitboard captureTargets = pos.byColor[us ^ 1];
+            if (pos.epSquare != -1) captureTargets |= squareBB(pos.epSquare);
+            Bitboard captures = pawnAttacks(fromSquare, us == WHITE) & captureTargets;
+            while (captures) {
+                int toSquare = popLsb(captures);
+                moves.add(packMove(fromSquare, toSquare, toSquare == pos.epSquare ? MOVE_EN_PASSANT : kind));
             }
         }
     }
     else if (tolower(piece) == 'n') {
-        // Логика для коня
-        int knightMoves[8][2] = {
-                {-2, -1}, {-2, 1},
-                {-1, -2}, {-1, 2},
-                {1, -2},  {1, 2},
-                {2, -1},  {2, 1}
-        };
-        for (auto& moveOffset : knightMoves) {
-            int toRow = fromRow + moveOffset[0];
-            int toCol = fromCol + moveOffset[1];
-            if (toRow >= 0 && toRow < SIZE && toCol >= 0 && toCol < SIZE) {
-                char targetPiece = state.board[toRow][toCol];
-                if (targetPiece == '.' || isOpponentPiece(piece, targetPiece)) {
-                    validMoves.push_back({piece, fromRow, fromCol, toRow, toCol, playerColor});
-                }
-            }
+        // Логика для коня: все поля из таблицы, кроме занятых своими фигурами
+        Bitboard targets = knightAttacks(fromSquare) & ~ownPieces;
+        while (targets) {
+            moves.add(packMove(fromSquare, popLsb(targets)));
         }
     }
-    else if (tolower(piece) == 'b') {
-        // Логика для слона
-        int directions[4][2] = {
-                {-1, -1}, {-1, 1},
-                {1, -1},  {1, 1}
-        };
-        for (auto& dir : directions) {
-            int toRow = fromRow;
-            int toCol = fromCol;
-            while (true) {
-                toRow += dir[0];
-                toCol += dir[1];
-                if (toRow < 0 || toRow >= SIZE || toCol < 0 || toCol >= SIZE) break;
-                char targetPiece = state.board[toRow][toCol];
-                if (targetPiece == '.') {
-                    validMoves.push_back({piece, fromRow, fromCol, toRow, toCol, playerColor});
-                } else {
-                    if (isOpponentPiece(piece, targetPiece)) {
-                        validMoves.push_back({piece, fromRow, fromCol, toRow, toCol, playerColor});
-                    }
-                    break;
-                }
-            }
-        }
-    }
-    else if (tolower(piece) == 'r') {
-        // Логика для ладьи
-        int directions[4][2] = {
-                {-1, 0}, {1, 0},
-                {0, -1}, {0, 1}
-        };
-        for (auto& dir : directions) {
-            int toRow = fromRow;
-            int toCol = fromCol;
-            while (true) {
-                toRow += dir[0];
-                toCol += dir[1];
-                if (toRow < 0 || toRow >= SIZE || toCol < 0 || toCol >= SIZE) break;
-                char targetPiece = state.board[toRow][toCol];
-                if (targetPiece == '.') {
-                    validMoves.push_back({piece, fromRow, fromCol, toRow, toCol, playerColor});
-                } else {
-                    if (isOpponentPiece(piece, targetPiece)) {
-                        validMoves.push_back({piece, fromRow, fromCol, toRow, toCol, playerColor});
-                    }
-                    break;
-                }
-            }
-        }
-    }
-    else if (tolower(piece) == 'q') {
-        // Логика для ферзя (комбинация ладьи и слона)
-        int directions[8][2] = {
-                {-1, -1}, {-1, 0}, {-1, 1},
-                {0, -1},          {0, 1},
-                {1, -1},  {1, 0},  {1, 1}
-        };
-        for (auto& dir : directions) {
-            int toRow = fromRow;
-            int toCol = fromCol;
-            while (true) {
-                toRow += dir[0];
-                toCol += dir[1];
-                if (toRow < 0 || toRow >= SIZE || toCol < 0 || toCol >= SIZE) break;
-                char targetPiece = state.board[toRow][toCol];
-                if (targetPiece == '.') {
-                    validMoves.push_back({piece, fromRow, fromCol, toRow, toCol, playerColor});
-                } else {
-                    if (isOpponentPiece(piece, targetPiece)) {
-                        validMoves.push_back({piece, fromRow, fromCol, toRow, toCol, playerColor});
-                    }
-                    break;
-                }
-            }
+    else if (tolower(piece) == 'b' || tolower(piece) == 'r' || tolower(piece) == 'q') {
+        // Логика для слона, ладьи и ферзя: атаки берутся из магических таблиц
+        Bitboard attacks;
+        if (tolower(piece) == 'b') attacks = bishopAttacks(fromSquare, pos.occupied);
+        else if (tolower(piece) == 'r') attacks = rookAttacks(fromSquare, pos.occupied);
+        else attacks = queenAttacks(fromSquare, pos.occupied);
+
+        Bitboard targets = attacks & ~ownPieces;
+        while (targets) {
+            moves.add(packMove(fromSquare, popLsb(targets)));
         }
     }
     else if (tolower(piece) == 'k') {
         // Логика для короля
-        int kingMoves[8][2] = {
-                {-1, -1}, {-1, 0}, {-1, 1},
-                {0, -1},          {0, 1},
-                {1, -1},  {1, 0},  {1, 1}
-        };
-        for (auto& moveOffset : kingMoves) {
-            int toRow = fromRow + moveOffset[0];
-            int toCol = fromCol + moveOffset[1];
-            if (toRow >= 0 && toRow < SIZE && toCol >= 0 && toCol < SIZE) {
-                char targetPiece = state.board[toRow][toCol];
-                if (targetPiece == '.' || isOpponentPiece(piece, targetPiece)) {
-                    validMoves.push_back({piece, fromRow, fromCol, toRow, toCol, playerColor});
-                }
-            }
+        Bitboard targets = kingAttacks(fromSquare) & ~ownPieces;
+        while (targets) {
+            moves.add(packMove(fromSquare, popLsb(targets)));
         }
-        // Логика для рокировки можно добавить здесь
-    }
-    // Добавьте дополнительные условия для других фигур, если необходимо
-
-    return validMoves;
-}
 
-// Функция проверки, является ли фигура противника
-bool BotPlayer::isOpponentPiece(char piece, char targetPiece) {
-    if ((piece >= 'A' && piece <= 'Z') && (targetPiece >= 'a' && targetPiece <= 'z')) {
-        return true;
-    }
-    if ((piece >= 'a' && piece <= 'z') && (targetPiece >= 'A' && targetPiece <= 'Z')) {
-        return true;
+        // Рокировка: король и ладья не ходили, между ними пусто,
+        // король не под шахом и не проходит через атакованное поле
+        int them = us ^ 1;
+        int kingSide = (us == WHITE) ? WHITE_OO : BLACK_OO;
+        int queenSide = (us == WHITE) ? WHITE_OOO : BLACK_OOO;
+        if ((pos.castlingRights & kingSide) &&
+            !(pos.occupied & (squareBB(fromSquare + 1) | squareBB(fromSquare + 2))) &&
+            !pos.isAttacked(fromSquare, them) && !pos.isAttacked(fromSquare + 1, them) &&
+            !pos.isAttacked(fromSquare + 2, them)) {
+            moves.add(packMove(fromSquare, fromSquare + 2, MOVE_CASTLING));
+        }
+        if ((pos.castlingRights & queenSide) &&
+            !(pos.occupied & (squareBB(fromSquare - 1) | squareBB(fromSquare - 2) | squareBB(fromSquare - 3))) &&
+            !pos.isAttacked(fromSquare, them) && !pos.isAttacked(fromSquare - 1, them) &&
+            !pos.isAttacked(fromSquare - 2, them)) {
+            moves.add(packMove(fromSquare, fromSquare - 2, MOVE_CASTLING));
+        }
     }
-    return false;
 }
 
 // Функция проверки, находится ли король под шахом
-bool BotPlayer::isInCheck(const GameState& state, char kingChar) {
-    int kingRow = -1, kingCol = -1;
-
-    // Находим позицию короля
-    for (int i = 0; i < SIZE; ++i) {
-        for (int j = 0; j < SIZE; ++j) {
-            if (state.board[i][j] == kingChar) {
-                kingRow = i;
-                kingCol = j;
-                break;
-            }
-        }
-        if (kingRow != -1) break;
-    }
-
-    if (kingRow == -1) return true; // Король отсутствует, считается под шахом
-
-    char opponentColor = (kingChar == 'K') ? 'B' : 'W';
+bool BotPlayer::isInCheck(const Position& pos, char kingChar) {
+    int kingColor = (kingChar == 'K') ? WHITE : BLACK;
+    int kingSquare = pos.kingSquare(kingColor);
 
-    // Проверяем, атакуют ли короля фигуры противника
-    std::vector<Move> opponentMoves = generateAllPossibleMoves(state, opponentColor);
+    if (kingSquare == -1) return true; // Король отсутствует, считается под шахом
 
-    for (const auto& move : opponentMoves) {
-        if (move.toRow == kingRow && move.toCol == kingCol) {
-            return true; // Король под шахом
-        }
-    }
-
-    return false; // Король не под шахом
+    return pos.isAttacked(kingSquare, kingColor ^ 1);
 }
 
 // Функция проверки, закончилась ли игра
-bool BotPlayer::isGameOver(const GameState& state) {
+bool BotPlayer::isGameOver(const Position& pos) {
     // Проверяем, есть ли оба короля на доске
-    bool whiteKingPresent = false;
-    bool blackKingPresent = false;
-    for (int i = 0; i < SIZE; ++i) {
-        for (int j = 0; j < SIZE; ++j) {
-            if (state.board[i][j] == 'K') whiteKingPresent = true;
-            if (state.board[i][j] == 'k') blackKingPresent = true;
-        }
-    }
-    return !(whiteKingPresent && blackKingPresent);
+    return pos.kingSquare(WHITE) == -1 || pos.kingSquare(BLACK) == -1;
 }
 
 // Функция копирования состояния игры
-void BotPlayer::copyGameState(const ChessGame& game, GameState& state) {
-    // Копируем доску
-    for (int i = 0; i < SIZE; ++i) {
-        std::copy(game.board[i], game.board[i] + SIZE, state.board[i]);
-    }
-    // Копируем списки захваченных фигур
-    state.whiteCapturedPieces = game.whiteCapturedPieces;
-    state.blackCapturedPieces = game.blackCapturedPieces;
-    // Дополнительно можно скопировать другие необходимые данные
+void BotPlayer::copyGameState(const ChessGame& game, Position& pos) {
+    // Позиция ChessGame уже содержит доску, права на рокировку и поле взятия на проходе
+    pos = game.position;
     std::cout << "copyGameState: State copied successfully." << std::endl;
-}
\ No newline at end of file
+}
@@ -4,54 +4,225 @@
 #define BOT_H
 
 #include "backend.h"
+#include "book.h"
+#include "pawns.h"
+#include "transposition.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 // Предварительное объявление класса ChessBoard
 class ChessBoard;
 
+// Ограничения поиска. Если задано moveTimeMs, оно имеет приоритет над часами.
+struct SearchLimits {
+    int moveTimeMs = 1000;   // Фиксированное время на ход, 0 - не задано
+    int clockMs = 0;         // Оставшееся время на часах
+    int incrementMs = 0;     // Добавка за ход
+    int maxDepth = 32;       // Предельная глубина итеративного углубления
+};
+
+// Включение и параметры отсечений поиска
+struct SearchOptions {
+    bool nullMove = true;            // Отсечение нулевым ходом
+    int nullMoveMinDepth = 3;        // Минимальная остаточная глубина для нулевого хода
+    int nullMoveReduction = 2;       // Сокращение глубины (плюс ещё одно на каждые 6 ply)
+    bool lateMoveReductions = true;  // Сокращение поздних тихих ходов
+    int lmrMinDepth = 3;             // Минимальная остаточная глубина для сокращения
+    int lmrMinMoves = 3;             // Столько первых ходов узла ищутся без сокращения
+};
+
 class BotPlayer {
 public:
     BotPlayer(ChessGame* game, ChessBoard* board = nullptr);
+    ~BotPlayer();
+    // С доской ищет ход в рабочем потоке и применяет его по Fl::awake, без доски - сразу
     void makeMove();
     void performBotMove();
+    // Прерывает поиск в рабочем потоке и отвязывает бота от доски.
+    // true - уведомление не отправлено, и бота удаляет вызывающий;
+    // false - объект удалит себя сам, когда дойдёт уже отправленное уведомление.
+    bool cancel();
+
+    // Общая для всех ботов таблица перестановок: переживает объект бота между ходами
+    static TranspositionTable& transpositionTable();
+    static void setHashSizeMB(size_t sizeMB);
+
+    // Общая дебютная книга: пока позиция в книге, ход берётся из неё без перебора
+    static OpeningBook& openingBook();
+
+    void setSearchLimits(const SearchLimits& newLimits) { limits = newLimits; }
+    void setSearchOptions(const SearchOptions& newOptions) { options = newOptions; }
+
+    // Число листьев дерева ходов генератора бота на глубине depth из позиции игры (perft).
+    // При divide печатает число листьев после каждого хода из корня.
+    long long perft(int depth, bool divide = false);
+
+    // Главный вариант последнего поиска, начиная с хода бота, и он же строкой
+    // в координатной записи ("e7e5 g1f3 b8c6")
+    std::vector<PackedMove> principalVariation() const;
+    std::string principalVariationText() const;
+
+    // Число потоков поиска (Lazy SMP): основной и threads - 1 вспомогательных
+    static const int MAX_THREADS = 256;
+    static void setThreadCount(int threads);
+    static int threadCount() { return searchThreads; }
 
 private:
     ChessGame* chessGame;
     ChessBoard* chessBoard;
 
-    int maxDepth;
+    SearchLimits limits;
+    SearchOptions options;
+
+    static int searchThreads;
+    // Вспомогательные потоки поиска переживают ход, как и таблицы: создаются при первой
+    // нужде и затем только получают новую позицию
+    static std::vector<std::unique_ptr<BotPlayer>>& searchHelpers();
+
+    // Номер потока поиска: 0 - основной, он управляет временем и выбирает ход
+    int threadId;
+    // Общий для всех потоков сигнал остановки; выставляет основной поток
+    std::atomic<bool>* stopSignal;
+    // Сдвиг порядка тихих ходов во вспомогательных потоках, чтобы потоки расходились по дереву
+    unsigned orderingSeed;
+
+    // Максимальная глубина стека отмены ходов
+    static const int MAX_PLY = 64;
+
+    // Оценки: мат через ply полуходов от корня - MATE_SCORE - ply, так что быстрый мат
+    // лучше медленного. INFINITE_SCORE недостижима и служит границей полного окна.
+    static const int MATE_SCORE = 1000000;
+    static const int INFINITE_SCORE = MATE_SCORE + 1;
+    static const int MATE_BOUND = MATE_SCORE - MAX_PLY;  // Оценки по модулю не меньше - маты
+
+    // В таблице перестановок мат хранится как расстояние от узла, а не от корня:
+    // та же позиция может встретиться на другом ply
+    static int scoreToTT(int score, int ply);
+    static int scoreFromTT(int score, int ply);
 
     struct BotMove {
-        Move move;
+        PackedMove move;
         int score;
     };
 
-    struct GameState {
-        char board[SIZE][SIZE];
-        std::vector<char> whiteCapturedPieces;
-        std::vector<char> blackCapturedPieces;
-    };
+    // Результат последней завершённой итерации этого потока и лучший ход корня текущей
+    BotMove rootBest;
+    PackedMove rootMove;
+    int completedDepth;
+
+    // Поиск в фоне для GUI: поток, флаг отмены, отправлено ли уведомление, и найденный ход
+    std::thread worker;
+    std::atomic<bool> cancelRequested;
+    std::atomic<bool> resultPosted;
+    BotMove searchResult;
+
+    // Позиция, на которой идёт перебор: ходы делаются и отменяются на месте
+    Position position;
+    UndoInfo undoStack[MAX_PLY];
+    int ply;
+
+    long long nodes;   // Число посещённых узлов в последнем поиске
+    long long qnodes;  // Из них узлов поиска взятий
+
+    // Счётчики срабатываний отсечений за последний поиск
+    long long nullMoveTries;    // Нулевой ход попробован
+    long long nullMoveCutoffs;  // и дал отсечение
+    long long lmrReductions;    // Поздний ход искался с сокращением
+    long long lmrResearches;    // и был перепроверен на полной глубине
+    long long pvsResearches;    // Нулевое окно PVS не доказало отсечение, ход перепроверен с полным
+    long long aspirationFails;  // Оценка корня вышла за окно стремления
+
+    // Пешечные структуры уже оценённых позиций. Таблицы, как и таблица перестановок,
+    // переживают объект бота между ходами: у каждого номера потока поиска своя.
+    // Одновременно идёт только один поиск.
+    static PawnTable& pawnTableFor(int thread);
+    PawnTable* pawnTable;  // Таблица этого потока, назначается в начале поиска
+
+    // Поиск взятий на листьях ограничен по глубине, чтобы не разрастался в длинных разменах
+    static const int MAX_QSEARCH_DEPTH = 8;
+    // Запас для дельта-отсечения: взятие, которое даже с ним не поднимает оценку до alpha, не смотрим
+    static const int DELTA_MARGIN = 200;
+
+    // Управление временем: поиск прерывается по достижении жёсткого лимита
+    std::chrono::steady_clock::time_point searchStart;
+    long long softTimeMs;  // После него новая итерация не начинается
+    long long hardTimeMs;  // После него текущая итерация прерывается
+    bool stopped;
+    int rootDepth;
+
+    // Главный вариант текущей итерации (треугольная таблица) и предыдущей
+    PackedMove pvTable[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+    PackedMove previousPV[MAX_PLY];
+    int previousPVLength;
+    bool followPV;
+    // Главный вариант, выбранный по итогам последнего поиска (из потока с самой глубокой итерацией)
+    PackedMove searchPV[MAX_PLY];
+    int searchPVLength;
+
+    // Окно стремления: полуширина вокруг оценки прошлой итерации, с какой глубины его ставить
+    // и после какой полуширины при неудаче переходить на полное окно
+    static const int ASPIRATION_WINDOW = 50;
+    static const int ASPIRATION_MIN_DEPTH = 4;
+    static const int ASPIRATION_FULL_WIDTH = 800;
+
+    // Упорядочивание ходов: два хода-убийцы на каждый ply и таблица истории [цвет][откуда][куда]
+    static const int PV_MOVE_SCORE = 4000000;
+    static const int TT_MOVE_SCORE = 3000000;
+    static const int CAPTURE_SCORE = 2000000;
+    static const int KILLER_SCORE_1 = 1000001;
+    static const int KILLER_SCORE_2 = 1000000;
+    static const int HISTORY_MAX = 900000;
+    static const int LOSING_CAPTURE_SCORE = -1000000;  // Взятия, проигрывающие размен, - после тихих ходов
+    PackedMove killers[MAX_PLY][2];
+    int history[2][64][64];
 
     static void botMoveCallback(void* data);
+    long long perftNode(int depth);
+    void searchInBackground();
+    BotMove search();
+    PackedMove probeBook();
+    void applyBotMove(const BotMove& bestMove);
+
+    void computeTimeBudget();
+    long long elapsedMs() const;
+    void checkTime();
 
-    BotMove minimax(const GameState& state, int depth, int alpha, int beta, bool isMaximizingPlayer);
+    void iterativeDeepening();
+    bool skipDepth(int depth) const;
+    // Тип узла перебора: корень, узел главного варианта (полное окно) или узел с нулевым окном
+    enum NodeType { NODE_ROOT, NODE_PV, NODE_NON_PV };
+    template <NodeType nodeType>
+    int negamax(int depth, int alpha, int beta);
+    int quiescence(int alpha, int beta, int qdepth);
 
-    int evaluateBoard(const GameState& state);
+    int evaluateBoard(const Position& pos);
 
-    std::vector<Move> generateAllPossibleMoves(const GameState& state, char playerColor);
+    void generateAllPossibleMoves(const Position& pos, char playerColor, MoveList& moves);
+    void generateCaptures(const Position& pos, char playerColor, MoveList& moves);
 
-    std::vector<Move> getValidMovesForPiece(const GameState& state, int fromRow, int fromCol, char playerColor);
+    void getValidMovesForPiece(const Position& pos, int fromRow, int fromCol, char playerColor, MoveList& moves);
 
-    void makeMoveOnBoard(GameState& state, const Move& move);
+    void updatePV(PackedMove move);
 
-    bool isGameOver(const GameState& state);
+    void clearMoveOrdering();
+    bool isCaptureMove(PackedMove move) const;
+    void scoreMoves(const MoveList& moves, int scores[], PackedMove ttMove, PackedMove pvMove);
+    void pickNextMove(MoveList& moves, int scores[], int index);
+    void updateQuietStats(PackedMove move, int depth);
 
-    bool isInCheck(const GameState& state, char kingChar);
+    void makeMoveOnBoard(PackedMove move);
+    void unmakeMoveOnBoard(PackedMove move);
 
-    void copyGameState(const ChessGame& game, GameState& state);
+    bool isGameOver(const Position& pos);
 
-    bool isOpponentPiece(char piece, char targetPiece);
+    bool isInCheck(const Position& pos, char kingChar);
 
-    int evaluateTactics(const GameState& state, char playerColor);
+    void copyGameState(const ChessGame& game, Position& pos);
 };
 
 #endif // BOT_H
\ No newline at end of file
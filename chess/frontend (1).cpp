@@ -15,13 +15,16 @@
 #include <ctime>
 
 ChessBoard::ChessBoard(int X, int Y, int W, int H, Fl_Box* msgBox, GameMode mode)
-        : Fl_Widget(X, Y, W, H), isPlayerTurn(true), gameOver(false), messageBox(msgBox), gameMode(mode), currentPlayer('W'), checkWindow(nullptr) {
+        : Fl_Widget(X, Y, W, H), isPlayerTurn(true), gameOver(false), messageBox(msgBox), gameMode(mode), currentPlayer('W'), activeBot(nullptr), checkWindow(nullptr) {
     loadPieceImages();
     updateMessage();
     chessGame = new ChessGame(mode);
 }
 
 ChessBoard::~ChessBoard() {
+    // Бот не должен дописывать ход в удалённую игру
+    cancelBot();
+
     // Освобождаем ресурсы
     for (auto& pair : pieceImages) {
         delete pair.second;
@@ -78,6 +81,14 @@ void ChessBoard::draw() {
                 fl_rect(x() + x_offset + j * cell_size, y() + 50 + i * cell_size, cell_size, cell_size);
             }
 
+            // Висящие фигуры игрока, чей ход: соперник выигрывает их разменом (шах отмечается отдельно)
+            char cellPiece = chessGame->board[i][j];
+            if (isPlayerTurn && cellPiece != '.' && tolower(cellPiece) != 'k' &&
+                (pieceColor(cellPiece) == WHITE) == (currentPlayer == 'W') && chessGame->isHanging(i, j)) {
+                fl_color(FL_MAGENTA);
+                fl_rect(x() + x_offset + j * cell_size + 2, y() + 50 + i * cell_size + 2, cell_size - 4, cell_size - 4);
+            }
+
             // Рисуем фигуры
             if (chessGame->board[i][j] != '.') {
                 char pieceChar = chessGame->board[i][j];
@@ -145,6 +156,12 @@ void ChessBoard::draw() {
 }
 
 int ChessBoard::handle(int event) {
+    if (event == FL_HIDE) {
+        // Окно закрыли: останавливаем поиск бота
+        cancelBot();
+        return Fl_Widget::handle(event);
+    }
+
     if (gameOver) {
         // Если игра окончена, игнорируем ввод
         return 0;
@@ -201,6 +218,15 @@ int ChessBoard::handle(int event) {
                         return 1;
                     }
 
+                    // Проверяем пат
+                    if (chessGame->isStalemate(opponentKing)) {
+                        gameOver = true;
+                        fl_message("Пат. Ничья.");
+                        updateMessage();
+                        showCheckWindow(false);
+                        return 1;
+                    }
+
                     // Проверяем шах
                     if (chessGame->isInCheck(opponentKing)) {
                         showCheckWindow(true);
@@ -209,18 +235,20 @@ int ChessBoard::handle(int event) {
                     }
 
                     // Смена хода
+                    currentPlayer = (currentPlayer == 'W') ? 'B' : 'W';
                     if (gameMode == AGAINST_FRIEND) {
-                        currentPlayer = (currentPlayer == 'W') ? 'B' : 'W';
                         isPlayerTurn = true;
                         updateMessage();
                     } else {
-                        // Против компьютера
-                        currentPlayer = 'B';
+                        // Против компьютера: бот ходит за сторону, чей теперь ход
                         isPlayerTurn = false;
                         updateMessage();
 
                         // Ход бота
                         BotPlayer* bot = new BotPlayer(chessGame, this);
+                        SearchLimits limits;
+                        limits.moveTimeMs = 2000;
+                        bot->setSearchLimits(limits);
                         bot->makeMove();
                     }
 
@@ -248,21 +276,19 @@ int ChessBoard::handle(int event) {
     }
 }
 
+void ChessBoard::cancelBot() {
+    if (activeBot) {
+        if (activeBot->cancel()) delete activeBot;
+        activeBot = nullptr;
+    }
+}
+
 void ChessBoard::updateMessage() {
     if (gameOver) {
         messageBox->label("Игра окончена");
-    } else if (isPlayerTurn) {
-        if (gameMode == AGAINST_FRIEND) {
-            messageBox->label(currentPlayer == 'W' ? "Ход белых" : "Ход чёрных");
-        } else {
-            messageBox->label("Ход белых");
-        }
     } else {
-        if (gameMode == AGAINST_FRIEND) {
-            messageBox->label(currentPlayer == 'W' ? "Ход белых" : "Ход чёрных");
-        } else {
-            messageBox->label("Ход чёрных");
-        }
+        // currentPlayer - сторона, чей ход, и в игре с другом, и против бота
+        messageBox->label(currentPlayer == 'W' ? "Ход белых" : "Ход чёрных");
     }
     messageBox->redraw();
 }
@@ -379,7 +405,11 @@ void ChessBoard::drawMoveHistory() {
     fl_color(FL_BLACK);
     fl_draw("История ходов:", startX, startY - 20);
 
-    for (size_t i = 0; i < chessGame->moveHistory.size(); ++i) {
+    // История хранится упакованной; фигуры восстанавливаются переигрыванием ходов
+    std::vector<Move> history;
+    chessGame->historyMoves(history);
+
+    for (size_t i = 0; i < history.size(); ++i) {
         int column = i % 2; // 0 для левого столбца, 1 для правого
         int row = i / 2;
 
@@ -391,7 +421,7 @@ void ChessBoard::drawMoveHistory() {
             break;
         }
 
-        Move& move = chessGame->moveHistory[i];
+        const Move& move = history[i];
 
         // Рисуем маленькое изображение фигуры
         if (smallPieceImages.count(move.piece)) {
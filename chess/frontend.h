@@ -31,6 +31,13 @@ public:
     bool gameOver;
     char currentPlayer;
 
+    // Бот, который сейчас думает в рабочем потоке (nullptr, если не думает).
+    // Бот удаляет себя в botMoveCallback; если уведомление ещё не отправлено,
+    // cancelBot удаляет его сам. Уведомление, отправленное перед самым выходом из Fl::run,
+    // может не дойти - такой бот освобождается только вместе с процессом.
+    BotPlayer* activeBot;
+    void cancelBot();
+
     friend class BotPlayer; // Даем доступ классу BotPlayer к приватным членам ChessBoard
 
 private:
@@ -6,7 +6,11 @@
 #include <FL/Fl_Box.H>
 #include "frontend.h"
 #include "backend.h"
+#include "bot.h"
+#include <cstdlib>
+#include <cstring>
 #include <locale>
+#include <thread>
 
 // Функция-обработчик для кнопок меню
 void startGame(Fl_Widget* widget, void* data) {
@@ -33,14 +37,28 @@ void startGame(Fl_Widget* widget, void* data) {
     menuWindow->hide();
 }
 
-// Главная функция
-int main() {
+// Главная функция.
+//   chess [-threads N] [-hash MB]
+// По умолчанию бот ищет во всех аппаратных потоках с таблицей перестановок 64 МБ.
+int main(int argc, char* argv[]) {
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    size_t hashMB = 64;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "-threads") == 0) threads = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "-hash") == 0) hashMB = static_cast<size_t>(std::atoi(argv[i + 1]));
+    }
+    BotPlayer::setThreadCount(threads);  // Сам ограничивает число потоков от 1 до MAX_THREADS
+    if (hashMB > 0) BotPlayer::setHashSizeMB(hashMB);
+
     // Инициализация генератора случайных чисел (если необходимо)
     srand(static_cast<unsigned>(time(0)));
 
     // Устанавливаем глобальную локаль для поддержки кириллицы
     std::locale::global(std::locale(""));
 
+    // Дебютная книга рядом с программой необязательна: без неё бот считает с первого хода
+    BotPlayer::openingBook().open("book.bin");
+
     // Создаём окно меню
     Fl_Window* menuWindow = new Fl_Window(300, 200, "Выбор режима игры");
 
@@ -64,6 +82,9 @@ int main() {
     menuWindow->end();
     menuWindow->show();
 
+    // Включаем поддержку потоков FLTK: бот присылает ход из рабочего потока через Fl::awake
+    Fl::lock();
+
     // Запуск основного цикла FLTK
     return Fl::run();
 }
\ No newline at end of file
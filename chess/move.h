@@ -0,0 +1,39 @@
+// move.h
+
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <cstdint>
+
+// Ход, упакованный в 16 бит:
+//   биты 0-5   - откуда (нумерация клеток из bitboard.h)
+//   биты 6-11  - куда
+//   биты 12-13 - фигура превращения (0 - конь ... 3 - ферзь)
+//   биты 14-15 - вид хода (MoveKind)
+// Ноль - "нет хода": ход a8-a8 невозможен.
+typedef uint16_t PackedMove;
+
+const PackedMove NO_MOVE = 0;
+
+enum MoveKind {
+    MOVE_NORMAL = 0,
+    MOVE_PROMOTION = 1 << 14,
+    MOVE_EN_PASSANT = 2 << 14,
+    MOVE_CASTLING = 3 << 14
+};
+
+// Фигуры превращения в порядке битов 12-13
+enum PromotionPiece {
+    PROMOTE_KNIGHT, PROMOTE_BISHOP, PROMOTE_ROOK, PROMOTE_QUEEN
+};
+
+inline PackedMove packMove(int from, int to, int kind = MOVE_NORMAL, int promotion = PROMOTE_QUEEN) {
+    return static_cast<PackedMove>(from | (to << 6) | (kind == MOVE_PROMOTION ? promotion << 12 : 0) | kind);
+}
+
+inline int moveFrom(PackedMove move) { return move & 63; }
+inline int moveTo(PackedMove move) { return (move >> 6) & 63; }
+inline int moveKind(PackedMove move) { return move & (3 << 14); }
+inline int movePromotion(PackedMove move) { return (move >> 12) & 3; }
+
+#endif // MOVE_H
@@ -0,0 +1,88 @@
+// pawns.cpp
+
+#include "pawns.h"
+
+namespace {
+// Штрафы и бонусы пешечной структуры: {миттельшпиль, эндшпиль}
+const int DOUBLED_MG = -10, DOUBLED_EG = -20;
+const int ISOLATED_MG = -10, ISOLATED_EG = -15;
+// Проходная пешка по числу шагов от начальной горизонтали (0 - на ней, 5 - за шаг до превращения)
+const int passedMg[6] = {5, 10, 20, 35, 60, 100};
+const int passedEg[6] = {10, 20, 35, 60, 100, 150};
+
+// Поля перед пешкой на её и соседних вертикалях: если там нет пешек соперника, пешка проходная
+Bitboard passedMask[2][64];
+// Соседние вертикали
+Bitboard adjacentFiles[8];
+
+struct PawnMaskInitializer {
+    PawnMaskInitializer() {
+        for (int col = 0; col < 8; ++col) {
+            adjacentFiles[col] = 0;
+            if (col > 0) adjacentFiles[col] |= FILE_A_BB << (col - 1);
+            if (col < 7) adjacentFiles[col] |= FILE_A_BB << (col + 1);
+        }
+        for (int square = 0; square < 64; ++square) {
+            Bitboard files = adjacentFiles[squareCol(square)] | (FILE_A_BB << squareCol(square));
+            Bitboard ahead[2] = {0, 0};
+            for (int row = 0; row < squareRow(square); ++row) ahead[WHITE] |= ROW_0_BB << (8 * row);
+            for (int row = squareRow(square) + 1; row < 8; ++row) ahead[BLACK] |= ROW_0_BB << (8 * row);
+            passedMask[WHITE][square] = files & ahead[WHITE];
+            passedMask[BLACK][square] = files & ahead[BLACK];
+        }
+    }
+} pawnMaskInitializer;
+}
+
+PawnTable::PawnTable(size_t entries) : table(entries), hitCount(0), missCount(0) {
+    // Нулевой ключ - позиция без пешек; пустую запись помечаем заведомо чужим ключом
+    for (PawnEntry& entry : table) entry.key = ~0ULL;
+}
+
+const PawnEntry& PawnTable::probe(const Position& pos) {
+    PawnEntry& entry = table[pos.pawnKey & (table.size() - 1)];
+    if (entry.key == pos.pawnKey) {
+        ++hitCount;
+        return entry;
+    }
+    ++missCount;
+    entry.key = pos.pawnKey;
+    evaluate(pos, entry);
+    return entry;
+}
+
+void PawnTable::evaluate(const Position& pos, PawnEntry& entry) {
+    entry.mg = entry.eg = 0;
+    for (int color = WHITE; color <= BLACK; ++color) {
+        int sign = (color == WHITE) ? 1 : -1;
+        Bitboard ours = pos.piecesOf(color, PAWN);
+        Bitboard theirs = pos.piecesOf(color ^ 1, PAWN);
+        entry.passed[color] = 0;
+
+        for (int col = 0; col < 8; ++col) {
+            int count = popCount(ours & (FILE_A_BB << col));
+            if (count == 0) continue;
+            if (count > 1) {
+                entry.mg += sign * DOUBLED_MG * (count - 1);
+                entry.eg += sign * DOUBLED_EG * (count - 1);
+            }
+            if (!(ours & adjacentFiles[col])) {
+                entry.mg += sign * ISOLATED_MG * count;
+                entry.eg += sign * ISOLATED_EG * count;
+            }
+        }
+
+        Bitboard pawns = ours;
+        while (pawns) {
+            int square = popLsb(pawns);
+            if (passedMask[color][square] & theirs) continue;
+            entry.passed[color] |= squareBB(square);
+            // Белые идут с шестой строки (row 6) к нулевой, чёрные - с первой к седьмой
+            int steps = (color == WHITE) ? 6 - squareRow(square) : squareRow(square) - 1;
+            if (steps < 0) steps = 0;  // Пешка на крайней горизонтали в произвольной расстановке
+            if (steps > 5) steps = 5;
+            entry.mg += sign * passedMg[steps];
+            entry.eg += sign * passedEg[steps];
+        }
+    }
+}
@@ -0,0 +1,39 @@
+// pawns.h
+
+#ifndef PAWNS_H
+#define PAWNS_H
+
+#include "position.h"
+#include <cstddef>
+#include <vector>
+
+// Оценка пешечной структуры одной позиции. Оценки в пользу белых, как в Position::evaluate.
+struct PawnEntry {
+    uint64_t key;        // Пешечный ключ Zobrist (Position::pawnKey)
+    int mg;              // Сдвоенные, изолированные и проходные пешки в миттельшпиле
+    int eg;              // То же в эндшпиле
+    Bitboard passed[2];  // Проходные пешки по цветам
+};
+
+// Хеш-таблица пешечных структур. Пешки за время поиска меняются редко, поэтому почти
+// каждая оценка листа находит структуру готовой. Таблица своя у каждого потока поиска.
+class PawnTable {
+public:
+    explicit PawnTable(size_t entries = 1 << 16);
+
+    // Запись для позиции; при промахе структура считается и сохраняется
+    const PawnEntry& probe(const Position& pos);
+
+    void resetStats() { hitCount = missCount = 0; }
+    long long hits() const { return hitCount; }
+    long long misses() const { return missCount; }
+
+private:
+    std::vector<PawnEntry> table;  // Размер - степень двойки
+    long long hitCount;
+    long long missCount;
+
+    static void evaluate(const Position& pos, PawnEntry& entry);
+};
+
+#endif // PAWNS_H
@@ -0,0 +1,146 @@
+// perft.cpp
+//
+// Подсчёт листьев дерева ходов (perft) для проверки и замера генераторов ходов.
+// Считается двумя способами: через проверку ходов ChessGame::isValidMove и через
+// генератор бота. Пешка всегда превращается в ферзя, поэтому эталонные числа взяты
+// для позиций и глубин, где превращений ещё нет.
+//
+//   perft                   - набор позиций с эталонными числами
+//   perft <depth> [fen]     - divide для позиции (по умолчанию начальная)
+
+#include "backend.h"
+#include "bot.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static std::string moveName(int fromRow, int fromCol, int toRow, int toCol) {
+    std::string name;
+    name += static_cast<char>('a' + fromCol);
+    name += static_cast<char>('8' - fromRow);
+    name += static_cast<char>('a' + toCol);
+    name += static_cast<char>('8' - toRow);
+    return name;
+}
+
+// Perft через ChessGame: каждая пара клеток проверяется isValidMove, ход делается на копии игры
+static long long perftValidator(ChessGame& game, int depth, bool divide) {
+    if (depth == 0) return 1;
+
+    long long total = 0;
+    char player = game.currentPlayer;
+    for (int fromRow = 0; fromRow < SIZE; ++fromRow) {
+        for (int fromCol = 0; fromCol < SIZE; ++fromCol) {
+            char piece = game.board[fromRow][fromCol];
+            if (piece == '.' || ((piece >= 'A' && piece <= 'Z') != (player == 'W'))) continue;
+
+            for (int toRow = 0; toRow < SIZE; ++toRow) {
+                for (int toCol = 0; toCol < SIZE; ++toCol) {
+                    if (!game.isValidMove(fromRow, fromCol, toRow, toCol, player)) continue;
+
+                    ChessGame child = game;
+                    child.movePiece(fromRow, fromCol, toRow, toCol);
+                    long long count = perftValidator(child, depth - 1, false);
+                    total += count;
+                    if (divide) {
+                        std::cout << moveName(fromRow, fromCol, toRow, toCol) << ": " << count << std::endl;
+                    }
+                }
+            }
+        }
+    }
+    return total;
+}
+
+struct PerftResult {
+    long long nodes;
+    double seconds;
+};
+
+static PerftResult runValidator(const std::string& fen, int depth, bool divide) {
+    ChessGame game(AGAINST_FRIEND);
+    game.loadFEN(fen);
+    auto start = std::chrono::steady_clock::now();
+    long long nodes = perftValidator(game, depth, divide);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {nodes, elapsed.count()};
+}
+
+static PerftResult runGenerator(const std::string& fen, int depth, bool divide) {
+    ChessGame game(AGAINST_FRIEND);
+    game.loadFEN(fen);
+    BotPlayer bot(&game);
+    auto start = std::chrono::steady_clock::now();
+    long long nodes = bot.perft(depth, divide);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return {nodes, elapsed.count()};
+}
+
+static void printResult(const char* name, const PerftResult& result) {
+    double nps = result.seconds > 0 ? result.nodes / result.seconds : 0;
+    std::cout << name << ": " << result.nodes << " nodes, " << result.seconds << " s, "
+              << static_cast<long long>(nps) << " nodes/s" << std::endl;
+}
+
+static const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct PerftCase {
+    const char* fen;
+    int validatorDepth;  // Проверка через ChessGame заметно медленнее, глубина меньше
+    int generatorDepth;
+    long long expected[5];  // Эталон для глубин 1..5
+};
+
+static const PerftCase PERFT_CASES[] = {
+    {START_FEN, 4, 5, {20, 400, 8902, 197281, 4865609}},
+    // "Kiwipete": рокировки, взятия на проходе, связки
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 3, {48, 2039, 97862}},
+    // Эндшпиль с шахами вскрытием и взятием на проходе под связкой
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 4, 5, {14, 191, 2812, 43238, 674624}},
+};
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        int depth = std::atoi(argv[1]);
+        std::string fen = START_FEN;
+        if (argc > 2) {
+            fen.clear();
+            for (int i = 2; i < argc; ++i) {
+                if (i > 2) fen += ' ';
+                fen += argv[i];
+            }
+        }
+        ChessGame check(AGAINST_FRIEND);
+        if (depth < 1 || !check.loadFEN(fen)) {
+            std::cout << "Использование: perft [<depth> [fen]]" << std::endl;
+            return 2;
+        }
+
+        std::cout << "ChessGame::isValidMove, depth " << depth << ":" << std::endl;
+        printResult("total", runValidator(fen, depth, true));
+        std::cout << std::endl << "BotPlayer generator, depth " << depth << ":" << std::endl;
+        printResult("total", runGenerator(fen, depth, true));
+        return 0;
+    }
+
+    int failures = 0;
+    for (const PerftCase& test : PERFT_CASES) {
+        std::cout << test.fen << std::endl;
+        for (int pass = 0; pass < 2; ++pass) {
+            int depth = (pass == 0) ? test.validatorDepth : test.generatorDepth;
+            const char* name = (pass == 0) ? "  ChessGame::isValidMove" : "  BotPlayer generator  ";
+            PerftResult result = (pass == 0) ? runValidator(test.fen, depth, false)
+                                             : runGenerator(test.fen, depth, false);
+            long long expected = test.expected[depth - 1];
+            printResult(name, result);
+            if (result.nodes != expected) {
+                std::cout << "  FAIL: depth " << depth << ", ожидалось " << expected << std::endl;
+                ++failures;
+            }
+        }
+    }
+
+    std::cout << (failures ? "Есть расхождения с эталоном" : "Все числа совпали с эталоном") << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,185 @@
+// pgn.cpp
+
+#include "pgn.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+static const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+PackedMove parseSAN(ChessGame& game, std::string san) {
+    // Отбрасываем шах, мат и оценки хода
+    while (!san.empty() && std::string("+#!?").find(san.back()) != std::string::npos) san.pop_back();
+    if (san.empty()) return NO_MOVE;
+
+    MoveList moves;
+    game.generateLegalMoves(moves);
+    const Position& pos = game.position;
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        bool queenSide = san.size() == 5;
+        for (PackedMove move : moves) {
+            if (moveKind(move) == MOVE_CASTLING && (moveTo(move) < moveFrom(move)) == queenSide) return move;
+        }
+        return NO_MOVE;
+    }
+
+    // Превращение: в позиции оно всегда в ферзя, другие фигуры не поддерживаются
+    size_t equals = san.find('=');
+    if (equals != std::string::npos) {
+        if (san.substr(equals + 1) != "Q") return NO_MOVE;
+        san.erase(equals);
+    }
+
+    char pieceType = 'p';
+    if (std::string("NBRQK").find(san[0]) != std::string::npos) {
+        pieceType = static_cast<char>(tolower(san[0]));
+        san.erase(0, 1);
+    }
+    san.erase(std::remove(san.begin(), san.end(), 'x'), san.end());
+    if (san.size() < 2) return NO_MOVE;
+
+    // Последние два символа - поле назначения, перед ними - необязательное уточнение
+    char toFile = san[san.size() - 2];
+    char toRank = san[san.size() - 1];
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8') return NO_MOVE;
+    int to = makeSquare('8' - toRank, toFile - 'a');
+    std::string hint = san.substr(0, san.size() - 2);
+
+    PackedMove found = NO_MOVE;
+    for (PackedMove move : moves) {
+        int from = moveFrom(move);
+        if (moveTo(move) != to || tolower(pos.pieceAt(from)) != pieceType) continue;
+        bool matches = true;
+        for (char c : hint) {
+            if (c >= 'a' && c <= 'h' && squareCol(from) != c - 'a') matches = false;
+            if (c >= '1' && c <= '8' && squareRow(from) != '8' - c) matches = false;
+        }
+        if (!matches) continue;
+        if (found != NO_MOVE) return NO_MOVE;
+        found = move;
+    }
+    return found;
+}
+
+// Итог партии в очках белых (0, 1, 2) или -1, если неизвестен
+static int resultPoints(const std::string& result) {
+    if (result == "1-0") return 2;
+    if (result == "0-1") return 0;
+    if (result == "1/2-1/2") return 1;
+    return -1;
+}
+
+// Добавляет ходы одной партии в книгу. Партия обрывается на первом нераспознанном ходе.
+static int addGame(const std::string& fen, const std::vector<std::string>& sanMoves, int whitePoints,
+                   int plies, BookWeights& weights) {
+    ChessGame game(AGAINST_FRIEND);
+    if (!game.loadFEN(fen)) return 0;
+
+    int added = 0;
+    for (const std::string& san : sanMoves) {
+        if (added >= plies) break;
+        PackedMove move = parseSAN(game, san);
+        if (move == NO_MOVE) {
+            std::cerr << "Не распознан ход " << san << ", партия обрезана" << std::endl;
+            break;
+        }
+        int points = (whitePoints < 0) ? 1 : (game.currentPlayer == 'W' ? whitePoints : 2 - whitePoints);
+        weights[std::make_pair(game.position.key, move)] += points;
+
+        int from = moveFrom(move);
+        int to = moveTo(move);
+        game.movePiece(squareRow(from), squareCol(from), squareRow(to), squareCol(to));
+        ++added;
+    }
+    return added;
+}
+
+int readPGN(std::istream& in, int plies, BookWeights& weights) {
+    int games = 0;
+    std::string fen = START_FEN;
+    std::string result;
+    std::vector<std::string> sanMoves;
+    bool inGame = false;
+
+    auto finishGame = [&]() {
+        if (!sanMoves.empty()) {
+            addGame(fen, sanMoves, resultPoints(result), plies, weights);
+            ++games;
+        }
+        fen = START_FEN;
+        result.clear();
+        sanMoves.clear();
+        inGame = false;
+    };
+
+    std::string line;
+    int variationDepth = 0;
+    bool inComment = false;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        if (!inComment && variationDepth == 0 && !line.empty() && line[0] == '[') {
+            // Тег начинает новую партию, если ходы предыдущей уже были
+            if (inGame) finishGame();
+            size_t quote = line.find('"');
+            size_t endQuote = line.rfind('"');
+            if (quote == std::string::npos || endQuote <= quote) continue;
+            std::string value = line.substr(quote + 1, endQuote - quote - 1);
+            if (line.compare(1, 4, "FEN ") == 0) fen = value;
+            if (line.compare(1, 7, "Result ") == 0) result = value;
+            continue;
+        }
+
+        std::string token;
+        auto flushToken = [&]() {
+            if (token.empty()) return;
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+                if (result.empty()) result = token;
+                finishGame();
+            } else if (token[0] != '$') {
+                // Номер хода может быть приклеен к ходу: "1.e4", "12...Nf6". Номер - это цифры
+                // с точками после них: в "0-0" цифра - часть рокировки
+                size_t start = 0;
+                size_t digits = token.find_first_not_of("0123456789");
+                if (digits > 0 && digits != std::string::npos && token[digits] == '.') {
+                    start = token.find_first_not_of('.', digits);
+                } else if (digits == std::string::npos) {
+                    start = std::string::npos;
+                }
+                if (start != std::string::npos) {
+                    sanMoves.push_back(token.substr(start));
+                    inGame = true;
+                }
+            }
+            token.clear();
+        };
+
+        for (char c : line) {
+            if (inComment) {
+                if (c == '}') inComment = false;
+            } else if (c == '{') {
+                flushToken();
+                inComment = true;
+            } else if (c == ';') {
+                break;
+            } else if (c == '(') {
+                flushToken();
+                ++variationDepth;
+            } else if (c == ')') {
+                token.clear();
+                if (variationDepth > 0) --variationDepth;
+            } else if (variationDepth > 0) {
+                continue;
+            } else if (c == ' ' || c == '\t') {
+                flushToken();
+            } else {
+                token += c;
+            }
+        }
+        if (variationDepth == 0) flushToken();
+    }
+    if (inGame) finishGame();
+    return games;
+}
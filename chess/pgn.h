@@ -0,0 +1,27 @@
+// pgn.h
+
+#ifndef PGN_H
+#define PGN_H
+
+#include "backend.h"
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <utility>
+
+// Разбор партий в PGN для сборки дебютной книги (book_builder.cpp).
+
+// Суммарный вес хода в позиции: (ключ, ход) -> вес
+typedef std::map<std::pair<uint64_t, PackedMove>, uint32_t> BookWeights;
+
+// Ход в записи SAN ("Nbd7", "exd5", "O-O", "0-0", "e8=Q+") среди легальных ходов текущей позиции.
+// NO_MOVE, если такого хода нет или запись неоднозначна.
+PackedMove parseSAN(ChessGame& game, std::string san);
+
+// Читает партии и добавляет первые plies полуходов каждой в weights. Вес хода - очки сделавшей
+// его стороны: победа 2, ничья 1, поражение 0, неизвестный итог 1. Теги, комментарии {...} и ;...,
+// варианты (...), NAG $n и номера ходов пропускаются. Возвращает число партий.
+int readPGN(std::istream& in, int plies, BookWeights& weights);
+
+#endif // PGN_H
@@ -0,0 +1,474 @@
+// position.cpp
+
+#include "position.h"
+#include <algorithm>
+
+namespace Zobrist {
+    uint64_t pieceSquare[PIECE_INDEX_NB][64];
+    uint64_t blackToMove;
+    uint64_t castling[16];
+    uint64_t enPassantFile[8];
+}
+
+namespace {
+// Генератор xorshift64* с фиксированным зерном: ключи одинаковы при каждом запуске,
+// поэтому их можно сохранять вместе с позициями
+uint64_t nextRandom(uint64_t& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+struct ZobristInitializer {
+    ZobristInitializer() {
+        uint64_t seed = 1070372ULL;
+        for (int piece = 0; piece < PIECE_INDEX_NB; ++piece) {
+            for (int square = 0; square < 64; ++square) {
+                Zobrist::pieceSquare[piece][square] = nextRandom(seed);
+            }
+        }
+        Zobrist::blackToMove = nextRandom(seed);
+
+        uint64_t rightKeys[4];
+        for (int i = 0; i < 4; ++i) rightKeys[i] = nextRandom(seed);
+        for (int rights = 0; rights < 16; ++rights) {
+            Zobrist::castling[rights] = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (rights & (1 << i)) Zobrist::castling[rights] ^= rightKeys[i];
+            }
+        }
+
+        for (int file = 0; file < 8; ++file) Zobrist::enPassantFile[file] = nextRandom(seed);
+    }
+} zobristInitializer;
+}
+
+void Position::clear() {
+    for (int i = 0; i < PIECE_INDEX_NB; ++i) pieces[i] = 0;
+    byColor[WHITE] = byColor[BLACK] = 0;
+    occupied = 0;
+    for (int sq = 0; sq < 64; ++sq) squares[sq] = '.';
+    kingSquares[WHITE] = kingSquares[BLACK] = -1;
+    sideToMove = WHITE;
+    castlingRights = 0;
+    epSquare = -1;
+    key = 0;
+    pawnKey = 0;
+    mgScore = egScore = phase = 0;
+}
+
+void Position::setFromBoard(const char board[8][8]) {
+    clear();
+    for (int row = 0; row < 8; ++row) {
+        for (int col = 0; col < 8; ++col) {
+            if (board[row][col] != '.') {
+                putPiece(board[row][col], makeSquare(row, col));
+            }
+        }
+    }
+}
+
+void Position::putPiece(char piece, int square) {
+    int index = pieceIndex(piece);
+    if (index < 0) return;
+    Bitboard b = squareBB(square);
+    pieces[index] |= b;
+    byColor[pieceColor(piece)] |= b;
+    occupied |= b;
+    squares[square] = piece;
+    if (index == W_KING || index == B_KING) kingSquares[pieceColor(piece)] = square;
+    key ^= Zobrist::pieceSquare[index][square];
+    if (index == W_PAWN || index == B_PAWN) pawnKey ^= Zobrist::pieceSquare[index][square];
+    mgScore += PSQT::mg[index][square];
+    egScore += PSQT::eg[index][square];
+    phase += PSQT::phaseWeight[index];
+}
+
+void Position::removePiece(int square) {
+    char piece = squares[square];
+    int index = pieceIndex(piece);
+    if (index < 0) return;
+    Bitboard b = squareBB(square);
+    pieces[index] &= ~b;
+    byColor[pieceColor(piece)] &= ~b;
+    occupied &= ~b;
+    squares[square] = '.';
+    if (index == W_KING || index == B_KING) {
+        // В учебных позициях королей одного цвета может быть больше одного
+        kingSquares[pieceColor(piece)] = pieces[index] ? lsb(pieces[index]) : -1;
+    }
+    key ^= Zobrist::pieceSquare[index][square];
+    if (index == W_PAWN || index == B_PAWN) pawnKey ^= Zobrist::pieceSquare[index][square];
+    mgScore -= PSQT::mg[index][square];
+    egScore -= PSQT::eg[index][square];
+    phase -= PSQT::phaseWeight[index];
+}
+
+void Position::setSideToMove(int color) {
+    if (color != sideToMove) {
+        sideToMove = color;
+        key ^= Zobrist::blackToMove;
+    }
+}
+
+void Position::setCastlingRights(int rights) {
+    key ^= Zobrist::castling[castlingRights] ^ Zobrist::castling[rights];
+    castlingRights = rights;
+}
+
+void Position::setEpSquare(int square) {
+    if (epSquare != -1) key ^= Zobrist::enPassantFile[squareCol(epSquare)];
+    epSquare = square;
+    if (epSquare != -1) key ^= Zobrist::enPassantFile[squareCol(epSquare)];
+}
+
+uint64_t Position::computeKey() const {
+    uint64_t result = 0;
+    for (int square = 0; square < 64; ++square) {
+        int index = pieceIndex(squares[square]);
+        if (index >= 0) result ^= Zobrist::pieceSquare[index][square];
+    }
+    if (sideToMove == BLACK) result ^= Zobrist::blackToMove;
+    result ^= Zobrist::castling[castlingRights];
+    if (epSquare != -1) result ^= Zobrist::enPassantFile[squareCol(epSquare)];
+    return result;
+}
+
+uint64_t Position::computePawnKey() const {
+    uint64_t result = 0;
+    for (int index : {W_PAWN, B_PAWN}) {
+        Bitboard pawns = pieces[index];
+        while (pawns) result ^= Zobrist::pieceSquare[index][popLsb(pawns)];
+    }
+    return result;
+}
+
+bool Position::isAttacked(int square, int attackerColor) const {
+    Bitboard queens = piecesOf(attackerColor, QUEEN);
+
+    // Пешка цвета C бьёт клетку, если с этой клетки пешка противоположного цвета бьёт её
+    if (pawnAttacks(square, attackerColor != WHITE) & piecesOf(attackerColor, PAWN)) return true;
+    if (knightAttacks(square) & piecesOf(attackerColor, KNIGHT)) return true;
+    if (kingAttacks(square) & piecesOf(attackerColor, KING)) return true;
+    // Таблицу атак дальнобойных смотрим, только если у нападающих такие фигуры остались
+    Bitboard diagonal = piecesOf(attackerColor, BISHOP) | queens;
+    if (diagonal && (bishopAttacks(square, occupied) & diagonal)) return true;
+    Bitboard straight = piecesOf(attackerColor, ROOK) | queens;
+    if (straight && (rookAttacks(square, occupied) & straight)) return true;
+    return false;
+}
+
+Bitboard Position::attackersTo(int square, int attackerColor, Bitboard occ) const {
+    Bitboard queens = piecesOf(attackerColor, QUEEN);
+    return (pawnAttacks(square, attackerColor != WHITE) & piecesOf(attackerColor, PAWN)) |
+           (knightAttacks(square) & piecesOf(attackerColor, KNIGHT)) |
+           (kingAttacks(square) & piecesOf(attackerColor, KING)) |
+           (bishopAttacks(square, occ) & (piecesOf(attackerColor, BISHOP) | queens)) |
+           (rookAttacks(square, occ) & (piecesOf(attackerColor, ROOK) | queens));
+}
+
+// Стоимость фигур для размена, по PieceType. Король дороже любого размена:
+// взятие под защиту королём так никогда не окупается.
+static const int SEE_VALUE[6] = {100, 320, 330, 500, 900, 20000};
+
+int Position::see(int from, int to) const {
+    int side = pieceColor(squares[from]);
+    int attackerType = pieceIndex(squares[from]) % 6;
+    Bitboard occ = occupied ^ squareBB(from);
+
+    // gain[d] - выигрыш стороны, сделавшей d-е взятие, если дальше не бьют
+    int gain[32];
+    int d = 0;
+    if (squares[to] != '.') {
+        gain[0] = SEE_VALUE[pieceIndex(squares[to]) % 6];
+    } else if (attackerType == PAWN && to == epSquare) {
+        gain[0] = SEE_VALUE[PAWN];
+        occ ^= squareBB(to + (side == WHITE ? 8 : -8));
+    } else {
+        gain[0] = 0;
+    }
+
+    Bitboard diagonal = pieces[W_BISHOP] | pieces[B_BISHOP] | pieces[W_QUEEN] | pieces[B_QUEEN];
+    Bitboard straight = pieces[W_ROOK] | pieces[B_ROOK] | pieces[W_QUEEN] | pieces[B_QUEEN];
+    Bitboard attackers = (attackersTo(to, WHITE, occ) | attackersTo(to, BLACK, occ)) & occ;
+
+    while (d < 31) {
+        side ^= 1;
+        Bitboard ours = attackers & byColor[side];
+        if (!ours) break;
+
+        // Следующее взятие - самой дешёвой фигурой
+        int type = PAWN;
+        Bitboard candidates = 0;
+        for (; type <= KING; ++type) {
+            candidates = ours & piecesOf(side, type);
+            if (candidates) break;
+        }
+
+        // Король не бьёт на поле, которое соперник ещё держит: такого взятия нет в размене.
+        // Дальнобойные за королём учитываем сразу - после его ухода они бьют поле.
+        if (type == KING) {
+            Bitboard occAfter = occ ^ candidates;
+            Bitboard defenders = attackers | (bishopAttacks(to, occAfter) & diagonal) |
+                                 (rookAttacks(to, occAfter) & straight);
+            if (defenders & occAfter & byColor[side ^ 1]) break;
+        }
+
+        ++d;
+        gain[d] = SEE_VALUE[attackerType] - gain[d - 1];
+        // Это взятие невыгодно ни при каком продолжении: сторона его не делает
+        if (std::max(-gain[d - 1], gain[d]) < 0) {
+            --d;
+            break;
+        }
+
+        attackerType = type;
+        occ ^= candidates & (0 - candidates);
+        // Ушедшая фигура могла открыть дальнобойную за собой
+        if (type == PAWN || type == BISHOP || type == QUEEN) attackers |= bishopAttacks(to, occ) & diagonal;
+        if (type == ROOK || type == QUEEN) attackers |= rookAttacks(to, occ) & straight;
+        attackers &= occ;
+    }
+
+    // Сворачиваем с конца: каждая сторона выбирает, бить дальше или остановиться
+    while (d > 0) {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        --d;
+    }
+    return gain[0];
+}
+
+int Position::exchangeGain(int square, int attackerColor) const {
+    int best = 0;
+    Bitboard attackers = attackersTo(square, attackerColor, occupied);
+    while (attackers) {
+        best = std::max(best, see(popLsb(attackers), square));
+    }
+    return best;
+}
+
+CheckInfo Position::checkInfo(int color) const {
+    CheckInfo info;
+    info.kingSquare = kingSquare(color);
+    info.checkers = info.pinned = 0;
+    info.checkMask = ~0ULL;
+    if (info.kingSquare == -1) return info;
+
+    int them = color ^ 1;
+    int king = info.kingSquare;
+    info.checkers = attackersTo(king, them, occupied);
+
+    // При одиночном шахе можно взять шахующую фигуру или перекрыть линию до неё.
+    // При двойном ходит только король, маска пустая.
+    if (info.checkers) {
+        info.checkMask = (popCount(info.checkers) == 1)
+                         ? info.checkers | betweenBB[king][lsb(info.checkers)]
+                         : 0;
+    }
+
+    // Связка: между королём и дальнобойной фигурой соперника ровно одна фигура, и она своя
+    Bitboard queens = piecesOf(them, QUEEN);
+    Bitboard snipers = (rookAttacks(king, 0) & (piecesOf(them, ROOK) | queens)) |
+                       (bishopAttacks(king, 0) & (piecesOf(them, BISHOP) | queens));
+    while (snipers) {
+        Bitboard blockers = betweenBB[king][popLsb(snipers)] & occupied;
+        if (blockers && !(blockers & (blockers - 1))) info.pinned |= blockers & byColor[color];
+    }
+    return info;
+}
+
+Bitboard Position::legalTargets(int from, const CheckInfo& info) const {
+    char piece = squares[from];
+    int index = pieceIndex(piece);
+    if (index < 0 || info.kingSquare == -1) return 0;
+
+    int us = pieceColor(piece);
+    int them = us ^ 1;
+    int type = index % 6;
+    Bitboard notOwn = ~byColor[us];
+
+    if (type == KING) {
+        // Король не может встать под бой; линии считаются без самого короля,
+        // чтобы он не "прятался" от дальнобойной фигуры на её же луче
+        Bitboard occ = occupied ^ squareBB(from);
+        Bitboard targets = kingAttacks(from) & notOwn;
+        Bitboard result = 0;
+        while (targets) {
+            int to = popLsb(targets);
+            if (!attackersTo(to, them, occ)) result |= squareBB(to);
+        }
+
+        // Рокировка: не из-под шаха, между королём и ладьёй пусто,
+        // клетки, через которые проходит король, не атакованы
+        int kingSide = (us == WHITE) ? WHITE_OO : BLACK_OO;
+        int queenSide = (us == WHITE) ? WHITE_OOO : BLACK_OOO;
+        if (!info.checkers) {
+            if ((castlingRights & kingSide) && !(occupied & betweenBB[from][from + 3]) &&
+                !attackersTo(from + 1, them, occupied) && !attackersTo(from + 2, them, occupied)) {
+                result |= squareBB(from + 2);
+            }
+            if ((castlingRights & queenSide) && !(occupied & betweenBB[from][from - 4]) &&
+                !attackersTo(from - 1, them, occupied) && !attackersTo(from - 2, them, occupied)) {
+                result |= squareBB(from - 2);
+            }
+        }
+        return result;
+    }
+
+    // При двойном шахе ходит только король
+    if (info.checkers & (info.checkers - 1)) return 0;
+
+    Bitboard targets = 0;
+    Bitboard epTarget = 0;
+    switch (type) {
+        case PAWN: {
+            Bitboard b = squareBB(from);
+            Bitboard empty = ~occupied;
+            Bitboard push = (us == WHITE) ? shiftNorth(b) & empty : shiftSouth(b) & empty;
+            Bitboard startRow = (us == WHITE) ? (ROW_7_BB >> 8) : (ROW_0_BB << 8);
+            if (b & startRow) push |= (us == WHITE) ? shiftNorth(push) & empty : shiftSouth(push) & empty;
+            targets = push | (pawnAttacks(from, us == WHITE) & byColor[them]);
+
+            // Взятие на проходе убирает с доски сразу две пешки, поэтому маски связок
+            // не подходят: проверяем линии до короля с занятостью после хода
+            Bitboard epRow = (us == WHITE) ? (ROW_0_BB << 16) : (ROW_0_BB << 40);
+            if (epSquare != -1 && (squareBB(epSquare) & epRow) && (pawnAttacks(from, us == WHITE) & squareBB(epSquare))) {
+                int capturedSquare = epSquare + (us == WHITE ? 8 : -8);
+                Bitboard occ = (occupied ^ squareBB(from) ^ squareBB(capturedSquare)) | squareBB(epSquare);
+                if (!(attackersTo(info.kingSquare, them, occ) & ~squareBB(capturedSquare))) {
+                    epTarget = squareBB(epSquare);
+                }
+            }
+            break;
+        }
+        case KNIGHT: targets = knightAttacks(from) & notOwn; break;
+        case BISHOP: targets = bishopAttacks(from, occupied) & notOwn; break;
+        case ROOK:   targets = rookAttacks(from, occupied) & notOwn; break;
+        case QUEEN:  targets = queenAttacks(from, occupied) & notOwn; break;
+    }
+
+    targets &= info.checkMask;
+    if (info.pinned & squareBB(from)) targets &= lineBB[info.kingSquare][from];
+    return targets | epTarget;
+}
+
+// Какие права на рокировку сохраняются, если ход затрагивает клетку square
+static int castlingRightsMask(int square) {
+    switch (square) {
+        case 56: return ~WHITE_OOO;             // a1
+        case 60: return ~(WHITE_OO | WHITE_OOO); // e1
+        case 63: return ~WHITE_OO;              // h1
+        case 0:  return ~BLACK_OOO;             // a8
+        case 4:  return ~(BLACK_OO | BLACK_OOO); // e8
+        case 7:  return ~BLACK_OO;              // h8
+        default: return ~0;
+    }
+}
+
+static bool isPawn(char piece) { return piece == 'P' || piece == 'p'; }
+static bool isKing(char piece) { return piece == 'K' || piece == 'k'; }
+
+PackedMove Position::encodeMove(int from, int to) const {
+    char piece = squares[from];
+    if (isKing(piece) && (to - from == 2 || from - to == 2)) {
+        return packMove(from, to, MOVE_CASTLING);
+    }
+    if (isPawn(piece)) {
+        if (squareRow(to) == 0 || squareRow(to) == 7) return packMove(from, to, MOVE_PROMOTION, PROMOTE_QUEEN);
+        if (to == epSquare && squareCol(from) != squareCol(to)) return packMove(from, to, MOVE_EN_PASSANT);
+    }
+    return packMove(from, to);
+}
+
+void Position::makeMove(int from, int to, UndoInfo& undo) {
+    char piece = squares[from];
+    int us = pieceColor(piece);
+
+    undo.movedPiece = piece;
+    undo.captured = squares[to];
+    undo.castlingRights = castlingRights;
+    undo.epSquare = epSquare;
+    undo.key = key;
+
+    if (undo.captured != '.') {
+        removePiece(to);
+    } else if (isPawn(piece) && to == epSquare && squareCol(from) != squareCol(to)) {
+        // Взятие на проходе: побитая пешка стоит позади поля назначения
+        int capturedSquare = to + (us == WHITE ? 8 : -8);
+        undo.captured = squares[capturedSquare];
+        removePiece(capturedSquare);
+    }
+
+    removePiece(from);
+    putPiece(piece, to);
+
+    if (isKing(piece) && (to - from == 2 || from - to == 2)) {
+        // Рокировка: переносим ладью через короля
+        int rookFrom = (to > from) ? from + 3 : from - 4;
+        int rookTo = (to > from) ? from + 1 : from - 1;
+        char rook = squares[rookFrom];
+        removePiece(rookFrom);
+        putPiece(rook, rookTo);
+    }
+
+    setEpSquare(-1);
+    if (isPawn(piece)) {
+        if (to - from == 16 || from - to == 16) {
+            setEpSquare((from + to) / 2);
+        } else if (squareRow(to) == 0 || squareRow(to) == 7) {
+            removePiece(to);
+            putPiece(us == WHITE ? 'Q' : 'q', to);
+        }
+    }
+
+    setCastlingRights(castlingRights & castlingRightsMask(from) & castlingRightsMask(to));
+    setSideToMove(us ^ 1);
+}
+
+void Position::makeNullMove(UndoInfo& undo) {
+    undo.movedPiece = '.';
+    undo.captured = '.';
+    undo.castlingRights = castlingRights;
+    undo.epSquare = epSquare;
+    undo.key = key;
+    setEpSquare(-1);
+    setSideToMove(sideToMove ^ 1);
+}
+
+void Position::unmakeNullMove(const UndoInfo& undo) {
+    sideToMove ^= 1;
+    epSquare = undo.epSquare;
+    key = undo.key;
+}
+
+void Position::unmakeMove(int from, int to, const UndoInfo& undo) {
+    char piece = undo.movedPiece;
+    int us = pieceColor(piece);
+
+    sideToMove ^= 1;
+    castlingRights = undo.castlingRights;
+    epSquare = undo.epSquare;
+
+    removePiece(to);
+    putPiece(piece, from);
+
+    if (isKing(piece) && (to - from == 2 || from - to == 2)) {
+        int rookFrom = (to > from) ? from + 3 : from - 4;
+        int rookTo = (to > from) ? from + 1 : from - 1;
+        char rook = squares[rookTo];
+        removePiece(rookTo);
+        putPiece(rook, rookFrom);
+    }
+
+    if (undo.captured != '.') {
+        if (isPawn(piece) && to == undo.epSquare && squareCol(from) != squareCol(to)) {
+            putPiece(undo.captured, to + (us == WHITE ? 8 : -8));
+        } else {
+            putPiece(undo.captured, to);
+        }
+    }
+
+    // Ключ менялся при перестановке фигур; восстанавливаем сохранённый целиком
+    key = undo.key;
+}
@@ -0,0 +1,185 @@
+// position.h
+
+#ifndef POSITION_H
+#define POSITION_H
+
+#include "bitboard.h"
+#include "move.h"
+
+enum PieceColor {
+    WHITE = 0,
+    BLACK = 1
+};
+
+enum PieceType {
+    PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING
+};
+
+// Индексы битовых досок: сначала белые фигуры, затем чёрные
+enum PieceIndex {
+    W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK, W_QUEEN, W_KING,
+    B_PAWN, B_KNIGHT, B_BISHOP, B_ROOK, B_QUEEN, B_KING,
+    PIECE_INDEX_NB
+};
+
+// Символ фигуры ('P', 'n', ...) -> индекс битовой доски, -1 для пустой клетки
+inline int pieceIndex(char piece) {
+    switch (piece) {
+        case 'P': return W_PAWN;
+        case 'N': return W_KNIGHT;
+        case 'B': return W_BISHOP;
+        case 'R': return W_ROOK;
+        case 'Q': return W_QUEEN;
+        case 'K': return W_KING;
+        case 'p': return B_PAWN;
+        case 'n': return B_KNIGHT;
+        case 'b': return B_BISHOP;
+        case 'r': return B_ROOK;
+        case 'q': return B_QUEEN;
+        case 'k': return B_KING;
+        default:  return -1;
+    }
+}
+
+inline char pieceChar(int index) {
+    return "PNBRQKpnbrqk"[index];
+}
+
+inline int pieceColor(char piece) {
+    return (piece >= 'A' && piece <= 'Z') ? WHITE : BLACK;
+}
+
+// Случайные ключи Zobrist. Ключ позиции - XOR ключей всех фигур на клетках,
+// ключа очереди хода (если ходят чёрные), прав на рокировку и вертикали взятия на проходе.
+namespace Zobrist {
+    extern uint64_t pieceSquare[PIECE_INDEX_NB][64];
+    extern uint64_t blackToMove;
+    extern uint64_t castling[16];      // По одному ключу на каждую комбинацию прав
+    extern uint64_t enPassantFile[8];
+}
+
+// Таблицы фигура-клетка для оценки: материал плюс позиционный бонус, для белых со знаком +,
+// для чёрных со знаком -. Отдельно для миттельшпиля и эндшпиля (psqt.cpp).
+namespace PSQT {
+    extern int mg[PIECE_INDEX_NB][64];
+    extern int eg[PIECE_INDEX_NB][64];
+    extern const int phaseWeight[PIECE_INDEX_NB];  // Вклад фигуры в фазу игры
+    const int TOTAL_PHASE = 24;                     // Фаза полного набора фигур
+}
+
+// Права на рокировку (битовая маска)
+enum CastlingRight {
+    WHITE_OO = 1,
+    WHITE_OOO = 2,
+    BLACK_OO = 4,
+    BLACK_OOO = 8
+};
+
+// Данные для отмены хода. Всё, что нельзя восстановить по самому ходу.
+struct UndoInfo {
+    char movedPiece;     // Фигура до хода (пешка при превращении)
+    char captured;       // Взятая фигура или '.'
+    int castlingRights;  // Права на рокировку до хода
+    int epSquare;        // Поле взятия на проходе до хода
+    uint64_t key;        // Ключ Zobrist до хода
+};
+
+// Шахи и связки одной стороны. Считаются один раз на позицию, после чего
+// легальность любого хода проверяется масками, без выполнения хода.
+struct CheckInfo {
+    int kingSquare;      // -1, если короля нет
+    Bitboard checkers;   // Фигуры соперника, объявившие шах
+    Bitboard pinned;     // Свои фигуры, связанные с королём
+    Bitboard checkMask;  // Поля, ход на которые закрывает от шаха или бьёт шахующую фигуру
+};
+
+// Битовое представление позиции: 12 досок фигур, маски занятости по цветам
+// и общая маска. Массив squares дублирует доску посимвольно, чтобы узнавать
+// фигуру на клетке без перебора всех 12 досок. Доски фигур служат и списками фигур:
+// обход popLsb стоит O(число фигур), а не O(64).
+struct Position {
+    Bitboard pieces[PIECE_INDEX_NB];
+    Bitboard byColor[2];
+    Bitboard occupied;
+    char squares[64];
+    int kingSquares[2];  // Клетки королей по цветам, -1 если короля нет; ведутся в putPiece/removePiece
+
+    int sideToMove;      // WHITE или BLACK
+    int castlingRights;  // Комбинация CastlingRight
+    int epSquare;        // Поле, на которое можно взять на проходе, или -1
+    uint64_t key;        // Ключ Zobrist, обновляется инкрементально при каждом изменении
+    uint64_t pawnKey;    // Ключ Zobrist только по пешкам - для пешечной хеш-таблицы
+
+    // Суммы таблиц PSQT по всем фигурам и фаза игры; ведутся в putPiece/removePiece
+    int mgScore;
+    int egScore;
+    int phase;
+
+    void clear();
+    void setFromBoard(const char board[8][8]);
+
+    void putPiece(char piece, int square);
+    void removePiece(int square);
+
+    // Изменение состояния позиции с обновлением ключа
+    void setSideToMove(int color);
+    void setCastlingRights(int rights);
+    void setEpSquare(int square);
+
+    // Полный пересчёт ключей с нуля (для проверки инкрементального обновления)
+    uint64_t computeKey() const;
+    uint64_t computePawnKey() const;
+
+    char pieceAt(int square) const { return squares[square]; }
+    Bitboard piecesOf(int color, int type) const { return pieces[color * 6 + type]; }
+
+    // Оценка в пользу белых: миттельшпильная и эндшпильная суммы смешиваются по фазе
+    int evaluate() const { return taper(mgScore, egScore); }
+
+    // Смешивание миттельшпильной и эндшпильной оценок по фазе текущей позиции
+    int taper(int mg, int eg) const {
+        int mgPhase = (phase < PSQT::TOTAL_PHASE) ? phase : PSQT::TOTAL_PHASE;
+        return (mg * mgPhase + eg * (PSQT::TOTAL_PHASE - mgPhase)) / PSQT::TOTAL_PHASE;
+    }
+
+    // Клетка короля цвета color или -1, если короля нет
+    int kingSquare(int color) const { return kingSquares[color]; }
+
+    // Атакована ли клетка фигурами цвета attackerColor
+    bool isAttacked(int square, int attackerColor) const;
+
+    // Фигуры цвета attackerColor, атакующие клетку при занятости occ
+    Bitboard attackersTo(int square, int attackerColor, Bitboard occ) const;
+
+    // Статическая оценка размена (SEE) на клетке to, начатого фигурой с клетки from: обе стороны
+    // бьют самой дешёвой фигурой и могут остановиться, когда размен перестаёт быть выгодным.
+    // Дальнобойные фигуры за ушедшими вступают в размен (рентген). Связки и превращения не учитываются.
+    int see(int from, int to) const;
+    // Лучший итог размена на клетке square для фигур цвета attackerColor; 0, если бить нечем или невыгодно.
+    // Больше нуля - фигура на клетке висит.
+    int exchangeGain(int square, int attackerColor) const;
+
+    // Шахи и связки для короля цвета color
+    CheckInfo checkInfo(int color) const;
+
+    // Все легальные поля назначения фигуры с клетки from (рокировка - ход короля на две клетки).
+    // info - результат checkInfo для цвета этой фигуры.
+    Bitboard legalTargets(int from, const CheckInfo& info) const;
+
+    // Упаковка хода с клетки from на to: вид хода определяется по фигуре и клеткам.
+    // Позиция должна быть той, в которой ход делается.
+    PackedMove encodeMove(int from, int to) const;
+
+    // Выполнение и отмена хода на месте, без копирования позиции.
+    // Рокировка, взятие на проходе и превращение в ферзя определяются по фигуре и клеткам.
+    void makeMove(int from, int to, UndoInfo& undo);
+    void unmakeMove(int from, int to, const UndoInfo& undo);
+    // Пустой ход: передаёт очередь хода, ничего не двигая (для отсечения нулевым ходом).
+    // В undo.movedPiece записывается '.', по этому признаку пустой ход узнаётся в стеке отмены.
+    void makeNullMove(UndoInfo& undo);
+    void unmakeNullMove(const UndoInfo& undo);
+    void makeMove(PackedMove move, UndoInfo& undo) { makeMove(moveFrom(move), moveTo(move), undo); }
+    void unmakeMove(PackedMove move, const UndoInfo& undo) { unmakeMove(moveFrom(move), moveTo(move), undo); }
+};
+
+#endif // POSITION_H
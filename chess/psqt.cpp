@@ -0,0 +1,117 @@
+// psqt.cpp
+
+#include "position.h"
+
+namespace PSQT {
+    int mg[PIECE_INDEX_NB][64];
+    int eg[PIECE_INDEX_NB][64];
+    const int phaseWeight[PIECE_INDEX_NB] = {0, 1, 1, 2, 4, 0, 0, 1, 1, 2, 4, 0};
+}
+
+namespace {
+// Материал по фазам: пешка в эндшпиле ценнее, остальное одинаково
+const int materialMg[6] = {100, 320, 330, 500, 900, 20000};
+const int materialEg[6] = {120, 320, 330, 500, 900, 20000};
+
+// Таблицы для белых, по строкам от восьмой горизонтали к первой (как нумерация клеток).
+// Для чёрных клетка отражается по вертикали: square ^ 56.
+const int pawnMg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+// В эндшпиле важно только продвижение пешки
+const int pawnEg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     80,  80,  80,  80,  80,  80,  80,  80,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     20,  20,  20,  20,  20,  20,  20,  20,
+     10,  10,  10,  10,  10,  10,  10,  10,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+const int knightTable[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50,
+};
+const int bishopTable[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20,
+};
+const int rookTable[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0,
+};
+const int queenTable[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+};
+// Король в миттельшпиле прячется за пешками, в эндшпиле идёт в центр
+const int kingMg[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20,
+};
+const int kingEg[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50,
+};
+
+const int* const tablesMg[6] = {pawnMg, knightTable, bishopTable, rookTable, queenTable, kingMg};
+const int* const tablesEg[6] = {pawnEg, knightTable, bishopTable, rookTable, queenTable, kingEg};
+
+// Итоговые таблицы: материал плюс позиция, со знаком цвета (белые +, чёрные -)
+struct PSQTInitializer {
+    PSQTInitializer() {
+        for (int type = PAWN; type <= KING; ++type) {
+            for (int square = 0; square < 64; ++square) {
+                PSQT::mg[W_PAWN + type][square] = materialMg[type] + tablesMg[type][square];
+                PSQT::eg[W_PAWN + type][square] = materialEg[type] + tablesEg[type][square];
+                PSQT::mg[B_PAWN + type][square] = -(materialMg[type] + tablesMg[type][square ^ 56]);
+                PSQT::eg[B_PAWN + type][square] = -(materialEg[type] + tablesEg[type][square ^ 56]);
+            }
+        }
+    }
+} psqtInitializer;
+}
@@ -2,19 +2,20 @@
 
 #include "backend.h"
 #include "bot.h"
+#include "pgn.h"
 #include <iostream>
-#include <cstring>
+#include <sstream>
 #include <vector>
 
 struct BotTestCase {
     std::string description;
-    char board[8][8];
+    std::string fen;  // Позиция вместе с очередью хода, рокировками и взятием на проходе
     char botColor; // 'W' или 'B'
 };
 
 struct RuleTestCase {
     std::string description;
-    char board[8][8];
+    std::string fen;
     // Для теста правил нам нужно знать, что мы проверяем.
     // Например, можно проверить ход, ожидаемый результат (true/false для isValidMove),
     // или состояние (isInCheck, isInCheckmate)
@@ -41,6 +42,33 @@ void printBoard(const char board[8][8]) {
     std::cout << "\n    A B C D E F G H\n";
 }
 
+// Обход дерева ходов на позиции игры: после каждого хода, отмены и пустого хода
+// инкрементальные ключи должны совпадать с пересчитанными с нуля
+bool checkKeys(ChessGame& game, int depth, long long& checked) {
+    Position& pos = game.position;
+    if (pos.key != pos.computeKey() || pos.pawnKey != pos.computePawnKey()) return false;
+    ++checked;
+    if (depth == 0) return true;
+
+    uint64_t key = pos.key;
+    uint64_t pawnKey = pos.pawnKey;
+    UndoInfo undo;
+    pos.makeNullMove(undo);
+    bool nullOk = pos.key == pos.computeKey() && pos.pawnKey == pos.computePawnKey();
+    pos.unmakeNullMove(undo);
+    if (!nullOk || pos.key != key || pos.pawnKey != pawnKey) return false;
+
+    MoveList moves;
+    game.generateLegalMoves(pos.sideToMove == WHITE ? 'W' : 'B', moves);
+    for (PackedMove move : moves) {
+        pos.makeMove(move, undo);
+        bool ok = checkKeys(game, depth - 1, checked);
+        pos.unmakeMove(move, undo);
+        if (!ok || pos.key != key || pos.pawnKey != pawnKey) return false;
+    }
+    return true;
+}
+
 // Создаём тесты для бота
 std::vector<BotTestCase> createBotTestCases() {
     std::vector<BotTestCase> testCases;
@@ -49,17 +77,7 @@ std::vector<BotTestCase> createBotTestCases() {
     {
         BotTestCase tc;
         tc.description = "Стандартная #1: Начальная позиция (ход белых)";
-        char initPos[8][8] = {
-                {'r','n','b','q','k','b','n','r'},
-                {'p','p','p','p','p','p','p','p'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'P','P','P','P','P','P','P','P'},
-                {'R','N','B','Q','K','B','N','R'}
-        };
-        memcpy(tc.board, initPos, sizeof(initPos));
+        tc.fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
         tc.botColor='W';
         testCases.push_back(tc);
     }
@@ -67,20 +85,9 @@ std::vector<BotTestCase> createBotTestCases() {
     {
         BotTestCase tc;
         tc.description = "Стандартная #2: Белые могут съесть подвисшую фигуру";
-        char pos[8][8] = {
-                {'r','n','b','q','k','b','n','r'},
-                {'p','p','p','p','p','p','.','p'},
-                {'.','.','.','.','.','.','p','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','P','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'P','P','P','P','.','P','P','P'},
-                {'R','N','B','Q','K','B','N','R'}
-        };
-        // Добавим подвисшего коня: чёрный конь на c6 (row=2,col=2)
-        pos[2][2]='n';
+        tc.fen = "rnbqkbnr/pppppp1p/2n3p1/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 1";
+        // Подвисший чёрный конь на c6 (row=2,col=2)
         // Белый слон на f1 уже есть, допустим бот сможет его использовать
-        memcpy(tc.board, pos, sizeof(pos));
         tc.botColor='W';
         testCases.push_back(tc);
     }
@@ -88,20 +95,8 @@ std::vector<BotTestCase> createBotTestCases() {
     {
         BotTestCase tc;
         tc.description = "Стандартная #3: Возможность короткой рокировки белых";
-        char pos[8][8]={
-                {'r','n','b','q','k','b','n','r'},
-                {'p','p','p','p','p','p','p','p'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'P','P','P','P','P','P','P','P'},
-                {'R','N','B','Q','K','B','N','R'}
-        };
-        // Уберем коня и слона, чтобы король мог рокировать
-        pos[7][6]='.'; // убираем N
-        pos[7][5]='.'; // убираем B
-        memcpy(tc.board,pos,sizeof(pos));
+        tc.fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQK2R w KQkq - 0 1";
+        // Конь и слон с королевского фланга убраны, король может рокировать
         tc.botColor='W';
         testCases.push_back(tc);
     }
@@ -109,17 +104,7 @@ std::vector<BotTestCase> createBotTestCases() {
     {
         BotTestCase tc;
         tc.description = "Стандартная #4: Ход чёрных пешкой в начале партии";
-        char initPos[8][8] = {
-                {'r','n','b','q','k','b','n','r'},
-                {'p','p','p','p','p','p','p','p'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'P','P','P','P','P','P','P','P'},
-                {'R','N','B','Q','K','B','N','R'}
-        };
-        memcpy(tc.board, initPos, sizeof(initPos));
+        tc.fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR b KQkq - 0 1";
         tc.botColor='B';
         testCases.push_back(tc);
     }
@@ -127,18 +112,8 @@ std::vector<BotTestCase> createBotTestCases() {
     {
         BotTestCase tc;
         tc.description = "Стандартная #5: Возможность взятия на проходе";
-        char pos[8][8]={
-                {'r','n','b','q','k','b','n','r'},
-                {'.','p','p','p','p','p','p','p'},
-                {'p','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'P','.','.','.','.','.','.','.'},
-                {'.','P','P','P','P','P','P','P'},
-                {'R','N','B','Q','K','B','N','R'}
-        };
+        tc.fen = "rnbqkbnr/1ppppppp/p7/8/8/P7/1PPPPPPP/RNBQKBNR b KQkq - 0 1";
         tc.botColor='B';
-        memcpy(tc.board,pos,sizeof(pos));
         testCases.push_back(tc);
     }
 
@@ -146,90 +121,40 @@ std::vector<BotTestCase> createBotTestCases() {
     {
         BotTestCase tc;
         tc.description = "Сложная #1: Матовая комбинация за два хода (белые)";
-        char pos[8][8]={
-                {'.','.','.','.','k','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','Q','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','K','.','.','.'},
-                {'.','.','.','.','.','.','.','.'}
-        };
+        tc.fen = "4k3/8/8/4Q3/8/8/4K3/8 w - - 0 1";
         tc.botColor='W';
-        memcpy(tc.board,pos,sizeof(pos));
         testCases.push_back(tc);
     }
 
     {
         BotTestCase tc;
         tc.description = "Сложная #2: Возможность вилки конём (белые)";
-        char pos[8][8]={
-                {'r','n','b','q','k','b','n','r'},
-                {'p','p','p','p','.','p','p','p'},
-                {'.','.','.','.','p','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','N','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'P','P','P','P','.','P','P','P'},
-                {'R','.','B','Q','K','B','.','R'}
-        };
+        tc.fen = "rnbqkbnr/pppp1ppp/4p3/8/5N2/8/PPPP1PPP/R1BQKB1R w KQkq - 0 1";
         tc.botColor='W';
-        memcpy(tc.board,pos,sizeof(pos));
         testCases.push_back(tc);
     }
 
     {
         BotTestCase tc;
         tc.description = "Сложная #3: Возможность отвлечения или связки (белые)";
-        char pos[8][8]={
-                {'r','n','b','q','k','b','n','r'},
-                {'p','p','p','.','p','p','p','p'},
-                {'.','.','.','p','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','P','.','.','.'},
-                {'.','.','R','.','.','.','.','.'},
-                {'P','P','P','P','.','P','P','P'},
-                {'R','N','B','Q','K','B','N','.'}
-        };
+        tc.fen = "rnbqkbnr/ppp1pppp/3p4/8/4P3/2R5/PPPP1PPP/RNBQKBN1 w Qkq - 0 1";
         tc.botColor='W';
-        memcpy(tc.board,pos,sizeof(pos));
         testCases.push_back(tc);
     }
 
     {
         BotTestCase tc;
         tc.description = "Сложная #4: Возможность жертвы ферзя (белые)";
-        char pos[8][8]={
-                {'r','n','b','q','k','.','n','r'},
-                {'p','p','p','p','.','p','p','p'},
-                {'.','.','.','.','p','.','.','.'},
-                {'.','.','.','N','.','.','.','.'},
-                {'.','.','.','.','P','.','.','.'},
-                {'.','.','.','Q','.','.','.','.'},
-                {'P','P','P','P','.','P','P','P'},
-                {'R','N','B','.','K','B','N','R'}
-        };
+        tc.fen = "rnbqk1nr/pppp1ppp/4p3/3N4/4P3/3Q4/PPPP1PPP/RNB1KBNR w KQkq - 0 1";
         tc.botColor='W';
-        memcpy(tc.board,pos,sizeof(pos));
         testCases.push_back(tc);
     }
 
     {
         BotTestCase tc;
         tc.description = "Сложная #5: Предотвращение немедленного мата (чёрные)";
-        char pos[8][8]={
-                {'.','.','.','.','k','.','.','.'},
-                {'.','.','.','.','.','Q','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','K','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'}
-        };
+        tc.fen = "4k3/5Q2/8/8/4K3/8/8/8 b - - 0 1";
         tc.botColor='B';
-        memcpy(tc.board,pos,sizeof(pos));
         testCases.push_back(tc);
     }
 
@@ -244,22 +169,12 @@ std::vector<RuleTestCase> createRuleTestCases() {
     {
         RuleTestCase tc;
         tc.description = "Правила #1: Недопустимый ход коня";
-        char pos[8][8] = {
-                {'r','n','b','q','k','b','n','r'},
-                {'p','p','p','p','p','p','p','p'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'P','P','P','P','P','P','P','P'},
-                {'R','N','B','Q','K','B','N','R'}
-        };
+        tc.fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
         tc.testType = RuleTestCase::CHECK_MOVE;
         tc.fromRow = 7; tc.fromCol = 1; // Белый конь на b1
         tc.toRow = 5; tc.toCol = 1;   // Пытаемся ходить прямо вперёд 2 клетки (недопустимо)
         tc.playerColor='W';
         tc.expectedMoveResult=false;
-        memcpy(tc.board, pos, sizeof(pos));
         testCases.push_back(tc);
     }
 
@@ -267,32 +182,13 @@ std::vector<RuleTestCase> createRuleTestCases() {
     {
         RuleTestCase tc;
         tc.description = "Правила #2: Ладья не может перепрыгнуть через фигуру";
-        char pos[8][8] = {
-                {'r','n','b','q','k','b','n','r'},
-                {'p','p','p','p','p','p','p','p'},
-                {'.','.','.','.','.','.','.','.'},
-                {'P','.','.','.','.','.','.','.'}, // Поставим белую пешку перед ладьёй
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','P','P','P','P','P','P','P'},
-                {'R','N','B','Q','K','B','N','R'}
-        };
-        // Белая ладья на a1 хочет пойти на a3, но на a4 стоит пешка (3,0) закрывая путь
-        // Внимание: индексы row идут сверху вниз. Мы поставим пешку на row=3,col=0 (a5 если смотреть на доску)
-        // Ладья a1 = (7,0), попробуем пойти на (4,0) - a4
-        // Между (7,0) и (4,0) стоит пешка на (3,0)? В текущей расстановке пешка на (3,0) - это пятая строка сверху?
-        // В основном виде:
-        // row=0 - верх
-        // row=7 - низ
-        // a1 это (7,0), a4 это (4,0)
-        // поставим пешку на row=5,col=0, чтобы она была между a1 и a4
-        pos[5][0]='P'; // пешка на a3 (с точки зрения реальной доски)
+        tc.fen = "rnbqkbnr/pppppppp/8/P7/8/P7/1PPPPPPP/RNBQKBNR w KQkq - 0 1";
+        // Белая ладья на a1 (7,0) хочет пойти на a4 (4,0), но на a3 (5,0) стоит белая пешка
         tc.testType=RuleTestCase::CHECK_MOVE;
         tc.fromRow=7;tc.fromCol=0; // Ладья a1
         tc.toRow=4;tc.toCol=0;     // a4
         tc.playerColor='W';
         tc.expectedMoveResult=false;
-        memcpy(tc.board,pos,sizeof(pos));
         testCases.push_back(tc);
     }
 
@@ -300,20 +196,10 @@ std::vector<RuleTestCase> createRuleTestCases() {
     {
         RuleTestCase tc;
         tc.description = "Правила #3: Король под шахом";
-        char pos[8][8]={
-                {'.','.','.','.','k','.','.','.'},
-                {'.','.','.','.','Q','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','K','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'}
-        };
+        tc.fen = "4k3/4Q3/8/8/4K3/8/8/8 b - - 0 1";
         tc.testType=RuleTestCase::CHECK_INCHECK;
         tc.kingChar='k'; // проверим чёрного короля
         tc.expectedBoolResult=true;
-        memcpy(tc.board,pos,sizeof(pos));
         testCases.push_back(tc);
     }
 
@@ -321,22 +207,12 @@ std::vector<RuleTestCase> createRuleTestCases() {
     {
         RuleTestCase tc;
         tc.description="Правила #4: Мат белому королю";
-        char pos[8][8]= {
-                {'r','n','b','q','.','b','n','r'},
-                {'p','p','p','p','.','p','p','p'},
-                {'.','.','.','.','p','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','k','.','.','.'},
-                {'.','.','.','.','Q','.','.','.'},
-                {'.','.','.','.','K','P','.','.'},
-                {'.','.','.','.','.','.','.','.'}
-        };
+        tc.fen = "rnbq1bnr/pppp1ppp/4p3/8/4k3/4Q3/4KP2/8 w - - 0 1";
         // Предположим белый король на e2 (6,4), черный король на e5 (4,4), ферзь чёрных ставит мат
         // Это искусственная ситуация, главное, чтобы isInCheckmate вернул true
         tc.testType=RuleTestCase::CHECK_INCHECKMATE;
         tc.kingChar='K'; // Проверим мат белому королю
         tc.expectedBoolResult=true;
-        memcpy(tc.board,pos,sizeof(pos));
         testCases.push_back(tc);
     }
 
@@ -344,16 +220,7 @@ std::vector<RuleTestCase> createRuleTestCases() {
     {
         RuleTestCase tc;
         tc.description="Правила #5: Пешка не может сделать двойной ход не с начальной позиции";
-        char pos[8][8]= {
-                {'r','n','b','q','k','b','n','r'},
-                {'p','p','p','p','p','p','p','p'},
-                {'.','.','.','.','.','.','.','.'},
-                {'P','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','.','.','.','.','.','.','.'},
-                {'.','P','P','P','P','P','P','P'},
-                {'R','N','B','Q','K','B','N','R'}
-        };
+        tc.fen = "rnbqkbnr/pppppppp/8/P7/8/8/1PPPPPPP/RNBQKBNR w KQkq - 0 1";
         // У нас белая пешка на a5 (row=3,col=0), попробуем пойти a3 (row=1,col=0) двумя ходами назад.
         // Это невозможно.
         tc.testType=RuleTestCase::CHECK_MOVE;
@@ -361,7 +228,6 @@ std::vector<RuleTestCase> createRuleTestCases() {
         tc.toRow=1;tc.toCol=0;
         tc.playerColor='W';
         tc.expectedMoveResult=false;
-        memcpy(tc.board,pos,sizeof(pos));
         testCases.push_back(tc);
     }
 
@@ -378,12 +244,11 @@ int main() {
         std::cout << "Тест " << testNumber++ << ": " << tc.description << "\n";
 
         ChessGame game(AGAINST_FRIEND);
-        for (int i=0;i<8;i++) {
-            for (int j=0;j<8;j++) {
-                game.board[i][j]=tc.board[i][j];
-            }
+        if (!game.loadFEN(tc.fen)) {
+            std::cout << "Некорректный FEN: " << tc.fen << "\n";
+            std::cout << "---------------------------------------\n";
+            continue;
         }
-        game.currentPlayer = tc.botColor;
 
         std::cout << "Начальная позиция:\n";
         printBoard(game.board);
@@ -400,7 +265,9 @@ int main() {
         if (game.moveHistory.empty()) {
             std::cout << "Бот не сделал ни одного хода.\n";
         } else {
-            Move lastMove = game.moveHistory.back();
+            std::vector<Move> history;
+            game.historyMoves(history);
+            Move lastMove = history.back();
             std::cout << "Бот сделал ход: " << lastMove.piece
                       << " (" << lastMove.fromRow << "," << lastMove.fromCol << ") -> ("
                       << lastMove.toRow << "," << lastMove.toCol << ")\n";
@@ -423,9 +290,10 @@ int main() {
     for (auto &tc : ruleTests) {
         std::cout << "Тест правил " << ruleTestNumber++ << ": " << tc.description << "\n";
         ChessGame game(AGAINST_FRIEND);
-        for (int i=0;i<8;i++)
-            for (int j=0;j<8;j++)
-                game.board[i][j]=tc.board[i][j];
+        if (!game.loadFEN(tc.fen)) {
+            std::cout << "FAIL: некорректный FEN: " << tc.fen << "\n";
+            continue;
+        }
 
         printBoard(game.board);
 
@@ -466,7 +334,177 @@ int main() {
     }
 
     std::cout << "Всего тестов для правил: " << ruleTests.size() << "\n";
-    std::cout << "Успешных тестов по правилам: " << ruleSuccessCount << "\n";
+    std::cout << "Успешных тестов по правилам: " << ruleSuccessCount << "\n\n";
+
+    // SEE: знак итога размена и число нападающих
+    std::cout << "Тесты SEE:\n";
+    {
+        struct SeeCase {
+            const char* description;
+            const char* fen;
+            int fromRow, fromCol, toRow, toCol;
+            int expectedSign;  // 1 - размен выгоден, -1 - проигрывает, 0 - ровно
+        };
+        const SeeCase cases[] = {
+            // exd5: пешка бьёт защищённого коня и сама гибнет - всё равно +220
+            {"Пешка бьёт защищённого коня", "4k3/2p5/8/3n4/4P3/8/8/4K3 w - - 0 1", 4, 4, 3, 3, 1},
+            // Qxd5: ферзь бьёт защищённую пешку
+            {"Ферзь бьёт защищённую пешку", "4k3/8/2p5/3p4/8/8/3Q4/4K3 w - - 0 1", 6, 3, 3, 3, -1},
+            // Rxe5 Rxe5 Rxe5: вторая ладья за первой вступает в размен через рентген
+            {"Батарея ладей через рентген", "4r1k1/8/8/4p3/8/8/4R3/4R1K1 w - - 0 1", 6, 4, 3, 4, 1},
+            // Без второй ладьи тот же размен проигрывает ладью за пешку
+            {"Одна ладья против защиты", "4r1k1/8/8/4p3/8/8/4R3/6K1 w - - 0 1", 6, 4, 3, 4, -1},
+            // bxa8: взятие с превращением, пешку отбивает король
+            {"Взятие с превращением", "rk6/1P6/8/8/8/8/8/4K3 w - - 0 1", 1, 1, 0, 0, 1},
+            // Rxd5 Rxd5: король последним не отбивает - d5 держит вторая ладья
+            {"Король против защищённого поля", "3r2k1/3r4/4K3/3p4/8/8/8/3R4 w - - 0 1", 7, 3, 3, 3, -1},
+            // Rxd5 Rxd5 Kxd5: без второй ладьи король забирает размен
+            {"Король отбивает незащищённое поле", "6k1/3r4/4K3/3p4/8/8/8/3R4 w - - 0 1", 7, 3, 3, 3, 1},
+            // Nxe5: слон и ферзь за ним защищают пешку лучше, чем ладья и ферзь нападают
+            {"Конь бьёт пешку под рентгеном", "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", 5, 3, 3, 4, -1},
+        };
+        int passed = 0;
+        int total = 0;
+        for (const SeeCase& tc : cases) {
+            ++total;
+            ChessGame game(AGAINST_FRIEND);
+            game.loadFEN(tc.fen);
+            int value = game.position.see(makeSquare(tc.fromRow, tc.fromCol), makeSquare(tc.toRow, tc.toCol));
+            int sign = (value > 0) - (value < 0);
+            if (sign == tc.expectedSign) {
+                ++passed;
+            } else {
+                std::cout << "FAIL: " << tc.description << ": SEE = " << value << "\n";
+            }
+        }
+
+        // Нападающие на e5 в позиции с рентгеном: напрямую конь и ладья, ферзь стоит за ладьёй
+        ++total;
+        ChessGame game(AGAINST_FRIEND);
+        game.loadFEN("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1");
+        if (popCount(game.attackersOf(3, 4, 'W')) == 2 && popCount(game.attackersOf(3, 4, 'B')) == 2 &&
+            game.isHanging(3, 4) == false) {
+            ++passed;
+        } else {
+            std::cout << "FAIL: нападающие на e5\n";
+        }
+
+        // Висящий ферзь: на d5 его бьёт ладья, защиты нет
+        ++total;
+        game.loadFEN("4k3/8/8/3q4/8/8/8/3RK3 b - - 0 1");
+        if (game.isHanging(3, 3) && !game.isHanging(7, 3)) {
+            ++passed;
+        } else {
+            std::cout << "FAIL: висящий ферзь\n";
+        }
+        std::cout << "Успешных тестов SEE: " << passed << " из " << total << "\n\n";
+    }
+
+    // Ключи Zobrist: рокировки, взятия на проходе, превращения и пустые ходы
+    std::cout << "Тесты ключей Zobrist:\n";
+    {
+        const char* fens[] = {
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+        };
+        for (const char* fen : fens) {
+            ChessGame game(AGAINST_FRIEND);
+            game.loadFEN(fen);
+            long long checked = 0;
+            bool ok = checkKeys(game, 3, checked);
+            std::cout << (ok ? "PASS" : "FAIL") << ": " << fen << " (" << checked << " позиций)\n";
+        }
+        std::cout << "\n";
+    }
+
+    // FEN и EPD: позиция, загруженная и записанная обратно, совпадает с исходной строкой
+    std::cout << "Тесты FEN и EPD:\n";
+    {
+        const char* fens[] = {
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",   // Взятие на проходе
+            "r3k3/8/8/8/8/8/8/4K2R b Kq - 12 47",                              // Часть рокировок и счётчики
+            "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        };
+        int passed = 0;
+        int total = 0;
+        for (const char* fen : fens) {
+            ++total;
+            ChessGame game(AGAINST_FRIEND);
+            if (game.loadFEN(fen) && game.toFEN() == fen) {
+                ++passed;
+            } else {
+                std::cout << "FAIL: " << fen << " -> " << game.toFEN() << "\n";
+            }
+        }
+
+        // Ход пешкой на два поля ставит поле взятия на проходе и сбрасывает счётчик полуходов
+        ++total;
+        ChessGame game(AGAINST_FRIEND);
+        game.loadFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        game.movePiece(6, 4, 4, 4);
+        const char* afterE4 = "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1";
+        if (game.toFEN() == afterE4) {
+            ++passed;
+        } else {
+            std::cout << "FAIL: после e2e4 " << game.toFEN() << "\n";
+        }
+
+        // Поле взятия на проходе не на той горизонтали или без пешки за ним - FEN отвергается
+        const char* badEnPassant[] = {
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e3 0 1",   // Горизонталь не та стороны
+            "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq e6 0 1",   // Пешки на e5 нет
+            "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq d3 0 1", // Пешки на d4 нет
+        };
+        for (const char* fen : badEnPassant) {
+            ++total;
+            ChessGame game(AGAINST_FRIEND);
+            if (!game.loadFEN(fen) && game.toFEN() == "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1") {
+                ++passed;
+            } else {
+                std::cout << "FAIL: принят " << fen << "\n";
+            }
+        }
+
+        // EPD: четыре поля позиции и операции после них
+        ++total;
+        std::string epd = "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - bm Bb5; id \"test.001\";";
+        std::string_view operations;
+        ChessGame epdGame(AGAINST_FRIEND);
+        if (epdGame.loadEPD(epd, &operations) && operations == "bm Bb5; id \"test.001\";" &&
+            epdGame.toEPD() == "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq -") {
+            ++passed;
+        } else {
+            std::cout << "FAIL: EPD " << epdGame.toEPD() << " | " << operations << "\n";
+        }
+        std::cout << "Успешных тестов FEN и EPD: " << passed << " из " << total << "\n\n";
+    }
+
+    // Разбор PGN для дебютной книги: рокировки в обеих записях, номера ходов, комментарии и варианты
+    std::cout << "Тесты PGN:\n";
+    {
+        std::istringstream pgn(
+            "[Event \"Castling\"]\n"
+            "[Result \"1-0\"]\n"
+            "\n"
+            "1. e4 e5 2. Nf3 Nc6 3. Bc4 {Итальянская} Bc5 4. 0-0 (4. c3 Nf6) Nf6\n"
+            "5. d3 O-O 6.Bg5 h6 1-0\n");
+        BookWeights weights;
+        int games = readPGN(pgn, 20, weights);
+        int castles = 0;
+        for (const auto& item : weights) {
+            if (moveKind(item.first.second) == MOVE_CASTLING) ++castles;
+        }
+        // Все 12 полуходов попали в книгу, обе рокировки распознаны
+        if (games == 1 && weights.size() == 12 && castles == 2) {
+            std::cout << "PASS\n";
+        } else {
+            std::cout << "FAIL: партий " << games << ", ходов " << weights.size()
+                      << ", рокировок " << castles << "\n";
+        }
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,119 @@
+// transposition.cpp
+
+#include "transposition.h"
+#include <new>
+
+namespace {
+uint64_t packData(PackedMove move, int score, int depth, int bound, uint8_t generation) {
+    return static_cast<uint64_t>(move) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(score)) << 16) |
+           (static_cast<uint64_t>(depth & 0xFF) << 48) |
+           (static_cast<uint64_t>(bound & 3) << 56) |
+           (static_cast<uint64_t>(generation & 63) << 58);
+}
+
+PackedMove dataMove(uint64_t data) { return static_cast<PackedMove>(data & 0xFFFF); }
+int dataScore(uint64_t data) { return static_cast<int32_t>(static_cast<uint32_t>(data >> 16)); }
+int dataDepth(uint64_t data) { return static_cast<int>((data >> 48) & 0xFF); }
+int dataBound(uint64_t data) { return static_cast<int>((data >> 56) & 3); }
+uint8_t dataGeneration(uint64_t data) { return static_cast<uint8_t>((data >> 58) & 63); }
+}
+
+TranspositionTable::TranspositionTable(size_t sizeMB)
+        : memory(nullptr), buckets(nullptr), bucketCount(0), megabytes(0), generation(0) {
+    resize(sizeMB);
+}
+
+TranspositionTable::~TranspositionTable() {
+    delete[] memory;
+}
+
+void TranspositionTable::resize(size_t sizeMB) {
+    if (sizeMB == 0) sizeMB = 1;
+
+    // Число корзин - наибольшая степень двойки, помещающаяся в sizeMB
+    size_t count = 1;
+    while (count * 2 * sizeof(TTBucket) <= sizeMB * 1024 * 1024) count *= 2;
+
+    delete[] memory;
+    // Выравниваем начало таблицы по линии кэша вручную: new не обязан это делать
+    memory = new char[count * sizeof(TTBucket) + 63];
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(memory) + 63) & ~static_cast<uintptr_t>(63);
+    buckets = reinterpret_cast<TTBucket*>(aligned);
+    for (size_t i = 0; i < count; ++i) new (&buckets[i]) TTBucket;
+    bucketCount = count;
+    megabytes = sizeMB;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < bucketCount; ++i) {
+        for (int j = 0; j < TTBucket::ENTRIES; ++j) {
+            buckets[i].entries[j].key.store(0, std::memory_order_relaxed);
+            buckets[i].entries[j].data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+void TranspositionTable::newSearch() {
+    generation = (generation + 1) & 63;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& data) const {
+    const TTBucket& bucket = bucketFor(key);
+    for (int i = 0; i < TTBucket::ENTRIES; ++i) {
+        const TTEntry& entry = bucket.entries[i];
+        uint64_t entryData = entry.data.load(std::memory_order_relaxed);
+        uint64_t entryKey = entry.key.load(std::memory_order_relaxed);
+        if (entryData != 0 && (entryKey ^ entryData) == key) {
+            data.move = dataMove(entryData);
+            data.score = dataScore(entryData);
+            data.depth = dataDepth(entryData);
+            data.bound = dataBound(entryData);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, int bound, int score, PackedMove move) {
+    TTBucket& bucket = bucketFor(key);
+    TTEntry* replace = &bucket.entries[0];
+    int replaceValue = 1 << 30;
+
+    for (int i = 0; i < TTBucket::ENTRIES; ++i) {
+        TTEntry& entry = bucket.entries[i];
+        uint64_t entryData = entry.data.load(std::memory_order_relaxed);
+        bool sameKey = entryData != 0 && (entry.key.load(std::memory_order_relaxed) ^ entryData) == key;
+        if (entryData == 0 || sameKey) {
+            // Пустая запись или та же позиция: лучший ход не теряем, если новый неизвестен
+            if (sameKey && move == NO_MOVE) move = dataMove(entryData);
+            replace = &entry;
+            break;
+        }
+        // Ценность записи: глубина минус штраф за возраст в поколениях
+        int age = (generation - dataGeneration(entryData)) & 63;
+        int value = dataDepth(entryData) - 8 * age;
+        if (value < replaceValue) {
+            replaceValue = value;
+            replace = &entry;
+        }
+    }
+
+    uint64_t data = packData(move, score, depth, bound, generation);
+    replace->key.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    size_t sample = bucketCount < 1000 ? bucketCount : 1000;
+    int used = 0;
+    for (size_t i = 0; i < sample; ++i) {
+        for (int j = 0; j < TTBucket::ENTRIES; ++j) {
+            uint64_t data = buckets[i].entries[j].data.load(std::memory_order_relaxed);
+            if (data != 0 && dataGeneration(data) == generation) ++used;
+        }
+    }
+    return static_cast<int>(used * 1000 / (sample * TTBucket::ENTRIES));
+}
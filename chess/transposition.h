@@ -0,0 +1,76 @@
+// transposition.h
+
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "move.h"
+
+// Тип оценки, сохранённой в таблице
+enum BoundType {
+    BOUND_NONE = 0,
+    BOUND_UPPER = 1,  // Настоящая оценка не больше сохранённой (не превысили alpha)
+    BOUND_LOWER = 2,  // Настоящая оценка не меньше сохранённой (отсечение по beta)
+    BOUND_EXACT = 3
+};
+
+// Распакованное содержимое записи
+struct TTData {
+    PackedMove move;  // NO_MOVE, если лучший ход неизвестен
+    int score;
+    int depth;
+    int bound;
+};
+
+// Запись таблицы: 16 байт, четыре записи занимают одну линию кэша.
+// Таблицей одновременно пользуются потоки поиска без блокировок, поэтому в поле key
+// хранится key ^ data: запись, слова которой записаны разными потоками, не пройдёт проверку.
+struct TTEntry {
+    std::atomic<uint64_t> key;
+    std::atomic<uint64_t> data;  // ход (16) | оценка (32) | глубина (8) | тип (2) | поколение (6)
+};
+
+struct alignas(64) TTBucket {
+    static const int ENTRIES = 4;
+    TTEntry entries[ENTRIES];
+};
+
+// Таблица перестановок фиксированного размера с корзинами по линии кэша.
+// При переполнении корзины вытесняется запись с наименьшей глубиной с поправкой на возраст.
+// probe и store можно вызывать из нескольких потоков; resize, clear и newSearch - только между поисками.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t sizeMB = 16);
+    ~TranspositionTable();
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    void resize(size_t sizeMB);
+    void clear();
+
+    // Вызывается в начале каждого поиска: записи прошлых поисков стареют
+    void newSearch();
+
+    bool probe(uint64_t key, TTData& data) const;
+    void store(uint64_t key, int depth, int bound, int score, PackedMove move);
+
+    // Заполненность в промилле по первой тысяче корзин
+    int hashfull() const;
+
+    size_t sizeMB() const { return megabytes; }
+
+private:
+    char* memory;
+    TTBucket* buckets;
+    size_t bucketCount;  // Степень двойки
+    size_t megabytes;
+    uint8_t generation;
+
+    TTBucket& bucketFor(uint64_t key) const { return buckets[key & (bucketCount - 1)]; }
+};
+
+#endif // TRANSPOSITION_H